@@ -0,0 +1,119 @@
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include "opLog/Config.h"
+#include "opLog/Payload.h"
+#include "opLog/appender/BinaryFileAppender.h"
+#include "opLog/appender/CompressedFileAppender.h"
+#include "opLog/appender/FileAppender.h"
+#include "opLog/appender/IoUringFileAppender.h"
+#include "opLog/formatter/PlainTextFormatter.h"
+
+// Throughput and bytes on disk per appender, for the same formatted records.
+// Usage: bench_appenders [records]
+
+namespace fs = std::filesystem;
+
+namespace {
+    uintmax_t directorySize(const fs::path& dir) {
+        uintmax_t total = 0;
+        for (const auto& entry : fs::recursive_directory_iterator(dir)) {
+            if (entry.is_regular_file()) total += entry.file_size();
+        }
+        return total;
+    }
+
+    void run(const std::string& name, const std::function<std::unique_ptr<IAppender>()>& make, size_t records) {
+        const fs::path dir = fs::temp_directory_path() / ("oplog-bench-" + name);
+        fs::remove_all(dir);
+        opLog::Config::getInstance().setLogDirectory(dir.string());
+
+        PlainTextFormatter formatter;
+
+        const auto start = std::chrono::steady_clock::now();
+        {
+            auto appender = make();
+            for (size_t i = 0; i < records; ++i) {
+                const LogRecord record{LogLevel::INFO,
+                                       "request id=" + std::to_string(i) + " user=alice path=/api/v1/items status=200",
+                                       std::chrono::system_clock::now()};
+                appender->write(record, formatter.format(record));
+            }
+            appender->flush();
+        }
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        const uintmax_t bytes = directorySize(dir);
+        std::cout << std::left << std::setw(28) << name
+                  << std::right << std::setw(14) << static_cast<uint64_t>(records / elapsed.count()) << " lines/s"
+                  << std::setw(14) << bytes << " bytes" << std::endl;
+        fs::remove_all(dir);
+    }
+
+    // A large body per record, either built into the message by the caller
+    // or attached as a Payload
+    void runPayload(const std::string& name, size_t bodySize, Payload::Encoding encoding, bool attach,
+                    size_t records) {
+        const fs::path dir = fs::temp_directory_path() / "oplog-bench-payload";
+        fs::remove_all(dir);
+        opLog::Config::getInstance().setLogDirectory(dir.string());
+
+        PlainTextFormatter formatter;
+        std::string body(bodySize, '\0');
+        for (size_t i = 0; i < bodySize; ++i) body[i] = static_cast<char>(i * 131 + 7);
+
+        const auto start = std::chrono::steady_clock::now();
+        {
+            FileAppender appender;
+            for (size_t i = 0; i < records; ++i) {
+                LogRecord record{LogLevel::INFO, "response id=" + std::to_string(i), std::chrono::system_clock::now()};
+                const Payload payload = Payload::borrow(body.data(), body.size(), encoding);
+                if (attach) {
+                    record.payload = payload;
+                } else {
+                    payload.appendTo(record.message);
+                }
+                appender.write(record, formatter.format(record));
+            }
+            appender.flush();
+        }
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        const uintmax_t bytes = directorySize(dir);
+        std::cout << std::left << std::setw(28) << name
+                  << std::right << std::setw(14) << static_cast<uint64_t>(bytes / elapsed.count() / 1e6) << " MB/s"
+                  << std::setw(16) << bytes << " bytes" << std::endl;
+        fs::remove_all(dir);
+    }
+}
+
+int main(int argc, char** argv) {
+    const size_t records = argc > 1 ? std::stoull(argv[1]) : 200000;
+
+    auto& config = opLog::Config::getInstance();
+    config.setColorsEnabled(false);
+    config.setMaxFileSize(1ULL << 40);
+
+    config.setAutoFlushEnabled(false);
+    run("FileAppender", [] { return std::make_unique<FileAppender>(); }, records);
+    run("IoUringFileAppender", [] { return std::make_unique<IoUringFileAppender>(); }, records);
+    run("CompressedFileAppender", [] { return std::make_unique<CompressedFileAppender>(); }, records);
+    run("BinaryFileAppender", [] { return std::make_unique<BinaryFileAppender>(); }, records);
+
+    config.setAutoFlushEnabled(true);
+    run("FileAppender(flush)", [] { return std::make_unique<FileAppender>(); }, records);
+    run("IoUringFileAppender(flush)", [] { return std::make_unique<IoUringFileAppender>(); }, records);
+
+    config.setAutoFlushEnabled(false);
+    const size_t bodies = std::max<size_t>(records / 200, 1);
+    runPayload("256K raw in message", 256 * 1024, Payload::Encoding::RAW, false, bodies);
+    runPayload("256K raw payload", 256 * 1024, Payload::Encoding::RAW, true, bodies);
+    runPayload("64K hex in message", 64 * 1024, Payload::Encoding::HEX, false, bodies * 4);
+    runPayload("64K hex payload", 64 * 1024, Payload::Encoding::HEX, true, bodies * 4);
+    runPayload("64K base64 payload", 64 * 1024, Payload::Encoding::BASE64, true, bodies * 4);
+    return 0;
+}
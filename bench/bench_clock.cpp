@@ -0,0 +1,70 @@
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <time.h>
+#include "opLog/TimeSource.h"
+
+// Cost per timestamp and drift from CLOCK_REALTIME for each clock_source.
+// Usage: bench_clock [calls] [drift seconds]
+
+namespace {
+    std::int64_t realtimeNs() {
+        timespec ts{};
+        ::clock_gettime(CLOCK_REALTIME, &ts);
+        return static_cast<std::int64_t>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+    }
+
+    std::int64_t toNs(TimeSource::TimePoint t) {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(t.time_since_epoch()).count();
+    }
+
+    void run(const std::string& name, ClockSource source, std::size_t calls, int driftSeconds) {
+        TimeSource::select(source, 1000);
+
+        std::int64_t sink = 0; // Keeps the calls from being optimized out
+        const auto start = std::chrono::steady_clock::now();
+        for (std::size_t i = 0; i < calls; ++i) {
+            sink += toNs(TimeSource::now());
+        }
+        const std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+
+        // Worst distance from the system clock, sampled every millisecond
+        // across several recalibrations
+        std::int64_t worst = 0;
+        const auto until = std::chrono::steady_clock::now() + std::chrono::seconds(driftSeconds);
+        while (std::chrono::steady_clock::now() < until) {
+            const std::int64_t before = realtimeNs();
+            const std::int64_t ours = toNs(TimeSource::now());
+            const std::int64_t after = realtimeNs();
+            std::int64_t error = 0;
+            if (ours < before) error = before - ours;
+            if (ours > after) error = ours - after;
+            worst = std::max(worst, error);
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        std::cout << std::left << std::setw(10) << name
+                  << std::right << std::setw(10) << std::fixed << std::setprecision(1)
+                  << elapsed.count() / static_cast<double>(calls) << " ns/call"
+                  << std::setw(12) << worst / 1000 << " us max drift"
+                  << (sink == 42 ? " " : "") << std::endl;
+    }
+}
+
+int main(int argc, char** argv) {
+    const std::size_t calls = argc > 1 ? std::stoull(argv[1]) : 10000000;
+    const int driftSeconds = argc > 2 ? std::stoi(argv[2]) : 3;
+
+    run("precise", ClockSource::PRECISE, calls, driftSeconds);
+    run("coarse", ClockSource::COARSE, calls, driftSeconds);
+    if (TimeSource::tscAvailable()) {
+        run("tsc", ClockSource::TSC, calls, driftSeconds);
+    } else {
+        std::cout << "tsc       not available (no invariant TSC)" << std::endl;
+    }
+    TimeSource::select(ClockSource::PRECISE);
+    return 0;
+}
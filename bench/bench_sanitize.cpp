@@ -0,0 +1,70 @@
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "opLog/formatter/MessageSanitizer.h"
+
+// Throughput of sanitize_messages against copying the message, for clean
+// messages and ones with a control character every 64 bytes.
+// Usage: bench_sanitize [megabytes per row]
+
+namespace {
+    std::size_t scalarFind(const char* data, std::size_t size) {
+        for (std::size_t i = 0; i < size; ++i) {
+            const auto c = static_cast<unsigned char>(data[i]);
+            if (c < 0x20 || c == 0x7f) return i;
+        }
+        return size;
+    }
+
+    template <typename Step>
+    void run(const std::string& name, const std::string& message, std::size_t megabytes, Step step) {
+        const std::size_t rounds = megabytes * 1024 * 1024 / message.size() + 1;
+        std::size_t sink = 0; // Keeps the work from being optimized out
+        const auto start = std::chrono::steady_clock::now();
+        for (std::size_t i = 0; i < rounds; ++i) {
+            sink += step(message);
+        }
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        const double bytes = static_cast<double>(rounds * message.size());
+
+        std::cout << std::left << std::setw(22) << name << std::right << std::setw(8) << message.size()
+                  << std::setw(10) << std::fixed << std::setprecision(2) << bytes / elapsed.count() / 1e9 << " GB/s"
+                  << std::setw(10) << std::setprecision(1) << elapsed.count() * 1e9 / rounds << " ns/msg"
+                  << (sink == 42 ? " " : "") << std::endl;
+    }
+}
+
+int main(int argc, char** argv) {
+    const std::size_t megabytes = argc > 1 ? std::stoull(argv[1]) : 512;
+
+    std::cout << std::left << std::setw(22) << "case" << std::right << std::setw(8) << "bytes"
+              << std::setw(15) << "throughput" << std::setw(17) << "per message" << std::endl;
+    for (const std::size_t size : {64, 256, 4096}) {
+        const std::string clean(size, 'x');
+        std::string dirty = clean;
+        for (std::size_t i = 63; i < size; i += 64) dirty[i] = '\n';
+
+        std::vector<char> target(size);
+        std::string out;
+        out.reserve(2 * size);
+        run("copy", clean, megabytes, [&](const std::string& m) {
+            std::memcpy(target.data(), m.data(), m.size());
+            return static_cast<std::size_t>(target[m.size() / 2]);
+        });
+        run("scan clean (scalar)", clean, megabytes, [](const std::string& m) {
+            return scalarFind(m.data(), m.size());
+        });
+        run("scan clean", clean, megabytes, [](const std::string& m) {
+            return MessageSanitizer::findUnsafe(m.data(), m.size());
+        });
+        run("escape dirty", dirty, megabytes, [&](const std::string& m) {
+            out.clear();
+            MessageSanitizer::appendEscaped(out, m);
+            return out.size();
+        });
+    }
+    return 0;
+}
@@ -0,0 +1,69 @@
+#ifndef BACKTRACERING_H
+#define BACKTRACERING_H
+
+#include <chrono>
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "LogLevel.h"
+#include "MemoryBudget.h"
+
+// Bounded ring of the most recent records below min_log_level, kept
+// unformatted so that holding one costs about a memcpy of the message into
+// a preallocated string. Logger replays the ring through its formatter and
+// appenders when a record at backtrace_trigger_level arrives, or on demand.
+class BacktraceRing {
+public:
+    struct Entry {
+        std::chrono::system_clock::time_point timestamp;
+        LogLevel level;
+        std::string message;
+    };
+
+private:
+    static constexpr std::size_t kMessageReserve = 128;
+
+    std::mutex mutex_;
+    std::vector<Entry> entries_;
+    std::vector<Entry> spare_; // Swapped in by drain() so push() never waits on appenders
+    std::size_t next_{0};
+    std::size_t count_{0};
+    MemoryBudget::Account memory_; // Both vectors and the message capacity in them
+
+public:
+    explicit BacktraceRing(std::size_t capacity);
+
+    // Overwrites the oldest record once full
+    void push(LogLevel level, const std::string& message, std::chrono::system_clock::time_point timestamp);
+
+    // Empties the ring and visits its records oldest first. Calls must be
+    // serialized by the caller; push() may run concurrently.
+    template<typename Visitor>
+    void drain(Visitor&& visit);
+
+    std::size_t capacity() const { return entries_.size(); }
+
+    // Held across fork() so the child never inherits a half-written entry
+    void prepareFork() { mutex_.lock(); }
+    void afterFork() { mutex_.unlock(); }
+};
+
+template<typename Visitor>
+void BacktraceRing::drain(Visitor&& visit) {
+    std::size_t first;
+    std::size_t count;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        entries_.swap(spare_);
+        first = (next_ + spare_.size() - count_) % spare_.size();
+        count = count_;
+        next_ = 0;
+        count_ = 0;
+    }
+    for (std::size_t i = 0; i < count; ++i) {
+        visit(static_cast<const Entry&>(spare_[(first + i) % spare_.size()]));
+    }
+}
+
+#endif //BACKTRACERING_H
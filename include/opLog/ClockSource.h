@@ -0,0 +1,10 @@
+#ifndef CLOCKSOURCE_H
+#define CLOCKSOURCE_H
+
+enum class ClockSource {
+    PRECISE, // std::chrono::system_clock (clock_gettime via the vDSO)
+    COARSE,  // CLOCK_REALTIME_COARSE: last tick, a few ms resolution
+    TSC,     // rdtsc scaled by a calibration refreshed in the background
+};
+
+#endif //CLOCKSOURCE_H
@@ -2,12 +2,19 @@
 #define CONFIG_H
 
 
+#include <atomic>
+#include <mutex>
 #include <string>
 #include <unordered_map>
 #include <vector>
+#include "opLog/ClockSource.h"
+#include "opLog/appender/ConsoleColors.h"
+#include "opLog/compression/CompressionCodec.h"
 #include "opLog/formatter/FormatStyle.h"
 #include "opLog/LogLevel.h"
 
+class ForkHandler;
+
 namespace opLog {
 
     struct LogLevelColors {
@@ -23,9 +30,17 @@ namespace opLog {
 
     class Config {
         private:
-            static Config* instance;
+            // Reloads publish a new instance; replaced ones are never freed,
+            // since callers may still hold references to them. That is one
+            // per applied reload, i.e. per edit of the config file.
+            static std::atomic<Config*> instance;
+            static std::vector<Config*> retired;
+            static std::atomic<unsigned> generation_;
+            static std::mutex mutex_; // Held while a file is parsed, and across fork()
             std::string configFilePath;
 
+            friend class ::ForkHandler;
+
             // Default config values
             std::string logDirectory{"./logs"};
             FormatStyle formatStyle{FormatStyle::STYLE_WITH_BRACKETS};
@@ -33,21 +48,112 @@ namespace opLog {
             LogLevel minLogLevel{LogLevel::TRACE};
             size_t maxFileSize{10 * 1024 * 1024}; // 10mb
             int maxBackupFiles{5};
+            long long rotationInterval{86400}; // seconds, 0 = size-based only
+            CompressionCodec compressRotated{CompressionCodec::NONE};
+            bool fileSharding{false}; // one file per writing thread
+            bool ioUring{false}; // IoUringFileAppender for text files
+            size_t ioUringBuffers{8}; // registered 64 KiB buffers in flight
+            size_t payloadMaxBytes{0}; // payload bytes written per record, 0 = all
+            bool binaryFormat{false}; // file_format=binary
+            bool shmRing{false}; // write through oplog-collector
+            std::string shmRingPrefix{"oplog-ring"};
+            size_t shmRingSlots{16384};
+            size_t binaryBlockRecords{4096};
+            size_t binaryBlockBytes{256 * 1024};
+            long long binaryBlockIntervalMs{1000}; // oldest record in the open block, 0 = no limit
+            bool timeIndex{false};
+            size_t timeIndexRecords{1000};
+            size_t timeIndexBytes{64 * 1024};
+
+            // CompressedFileAppender
+            CompressionCodec streamCompression{CompressionCodec::GZIP};
+            size_t compressionFrameSize{64 * 1024};
+            long long compressionFrameIntervalMs{1000};
+            bool maxFileSizeCompressed{true}; // max_file_size counts compressed bytes
+
+            ClockSource clockSource{ClockSource::PRECISE};
+            long long tscCalibrationMs{1000};
+            bool asyncLogging{false}; // hand records to the shared LogDispatcher pool
+            size_t asyncWorkers{2}; // 0 = half the hardware threads
+            size_t asyncQueueRecords{8192}; // per logger, producers wait when full
+            size_t asyncQuantum{256}; // records per logger per turn
+            long long asyncIdleMs{2000}; // idle workers exit after this long
+            size_t backtraceSize{0}; // records kept below min_log_level, 0 = off
+            LogLevel backtraceTriggerLevel{LogLevel::ERROR};
+            bool crashHandler{false}; // flush on SIGSEGV/SIGABRT/SIGBUS/SIGFPE/std::terminate
+            bool crashBacktrace{true};
+            bool forkSafe{true}; // pthread_atfork handlers, see ForkHandler
+            bool forkPidSuffix{false}; // children log to <name>.p<pid>.<ext>
+            bool watchConfig{false}; // reload on edits, see ConfigWatcher
+            long long watchDebounceMs{250};
+            size_t memoryBudget{0}; // bytes opLog may hold, 0 = unlimited
+            size_t memoryFlushPercent{75}; // of the budget, before flushing early
+            LogLevel memoryShedLevel{LogLevel::WARN}; // kept when over budget
+
+            // UnixSocketAppender
+            std::string socketPath{"/run/oplog/agent.sock"};
+            bool socketStream{false}; // socket_type=stream, otherwise datagrams
+            size_t socketBufferBytes{4 * 1024 * 1024}; // spill buffer while the agent is down
+
+            // ConsoleAppender
+            ConsoleColors consoleColors{ConsoleColors::AUTO};
+            bool consoleSplitStderr{false};
+            LogLevel consoleStderrLevel{LogLevel::WARN};
+            long long consoleFlushIntervalMs{200}; // oldest held output with auto_flush off, 0 = no limit
             bool enableColors{true};
             bool enableTimestamp{true};
             std::string dateTimeFormat = "%Y-%m-%d %H:%M:%S";
+            bool sanitizeMessages{false}; // escape control characters in messages
             bool autoFlush = true;
 
             Config() = default;
+            Config(const Config&) = default;
+
+            // Returns how many lines had a value that failed to parse
+            int parseConfigFile(const std::string& filepath);
+            // Parses `path` into a copy of `base` and publishes it if it
+            // validates; otherwise reports why and returns false. Requires mutex_
+            static bool publishFromFile(const Config& base, const std::string& path);
+
+            // Bumps generation() and tells the components that cache
+            // settings. Requires mutex_
+            static void changed();
 
-            void parseConfigFile(const std::string& filepath);
+            // Setters write to the published instance, whichever one they are
+            // called through
+            template<typename T, typename V>
+            static void set(T Config::* field, const V& value) {
+                std::lock_guard<std::mutex> lock(mutex_);
+                instance.load(std::memory_order_relaxed)->*field = value;
+                changed();
+            }
+            static void setColor(std::string LogLevelColors::* color, const std::string& value) {
+                std::lock_guard<std::mutex> lock(mutex_);
+                instance.load(std::memory_order_relaxed)->colors.*color = value;
+                changed();
+            }
+            // Settings that cannot work together or at all; empty if none
+            std::vector<std::string> validate() const;
             void setDefaultConfig();
             std::string trim(const std::string& str);
             std::vector<std::string> split(const std::string& str, char delimiter);
+            CompressionCodec parseCodec(const std::string& value, CompressionCodec current);
+            LogLevel parseLevel(const std::string& value, LogLevel current);
+            static const char* levelToString(LogLevel level);
 
     public:
+        // The reference stays valid for the life of the process. Its getters
+        // keep returning the settings it was taken with once a reload has
+        // replaced it; call getInstance() again to see the reload. Setters
+        // change the published settings through any reference.
         static Config& getInstance();
+        // Applies the config file's settings, warning about lines that do
+        // not parse. Does nothing if that file is already loaded; use
+        // reloadConfig() to read it again.
         static void initialize(const std::string& configPath = "");
+        // Bumped by every setter, load and reload, for components that cache
+        // settings
+        static unsigned generation() { return generation_.load(std::memory_order_acquire); }
 
         //Getters:
         const std::string& getLogDirectory() const { return logDirectory; }
@@ -56,32 +162,129 @@ namespace opLog {
         LogLevel getMinLogLevel() const { return minLogLevel; }
         size_t getMaxFileSize() const { return maxFileSize; }
         int getMaxBackupFiles() const { return maxBackupFiles; }
+        long long getRotationInterval() const { return rotationInterval; }
+        CompressionCodec getCompressRotated() const { return compressRotated; }
+        bool isFileShardingEnabled() const { return fileSharding; }
+        bool isIoUringEnabled() const { return ioUring; }
+        size_t getIoUringBuffers() const { return ioUringBuffers; }
+        size_t getPayloadMaxBytes() const { return payloadMaxBytes; }
+        bool isBinaryFormat() const { return binaryFormat; }
+        bool isShmRingEnabled() const { return shmRing; }
+        const std::string& getShmRingPrefix() const { return shmRingPrefix; }
+        size_t getShmRingSlots() const { return shmRingSlots; }
+        size_t getBinaryBlockRecords() const { return binaryBlockRecords; }
+        size_t getBinaryBlockBytes() const { return binaryBlockBytes; }
+        long long getBinaryBlockIntervalMs() const { return binaryBlockIntervalMs; }
+        bool isTimeIndexEnabled() const { return timeIndex; }
+        size_t getTimeIndexRecords() const { return timeIndexRecords; }
+        size_t getTimeIndexBytes() const { return timeIndexBytes; }
+        CompressionCodec getStreamCompression() const { return streamCompression; }
+        size_t getCompressionFrameSize() const { return compressionFrameSize; }
+        long long getCompressionFrameIntervalMs() const { return compressionFrameIntervalMs; }
+        bool isMaxFileSizeCompressed() const { return maxFileSizeCompressed; }
+        ClockSource getClockSource() const { return clockSource; }
+        long long getTscCalibrationMs() const { return tscCalibrationMs; }
+        bool isAsyncLogging() const { return asyncLogging; }
+        size_t getAsyncWorkers() const { return asyncWorkers; }
+        size_t getAsyncQueueRecords() const { return asyncQueueRecords; }
+        size_t getAsyncQuantum() const { return asyncQuantum; }
+        long long getAsyncIdleMs() const { return asyncIdleMs; }
+        size_t getBacktraceSize() const { return backtraceSize; }
+        LogLevel getBacktraceTriggerLevel() const { return backtraceTriggerLevel; }
+        bool isCrashHandlerEnabled() const { return crashHandler; }
+        bool isCrashBacktraceEnabled() const { return crashBacktrace; }
+        bool isForkSafe() const { return forkSafe; }
+        bool isForkPidSuffix() const { return forkPidSuffix; }
+        bool isWatchConfig() const { return watchConfig; }
+        long long getWatchDebounceMs() const { return watchDebounceMs; }
+        const std::string& getConfigFilePath() const { return configFilePath; }
+        size_t getMemoryBudget() const { return memoryBudget; }
+        size_t getMemoryFlushPercent() const { return memoryFlushPercent; }
+        LogLevel getMemoryShedLevel() const { return memoryShedLevel; }
+        const std::string& getSocketPath() const { return socketPath; }
+        bool isSocketStream() const { return socketStream; }
+        size_t getSocketBufferBytes() const { return socketBufferBytes; }
+        ConsoleColors getConsoleColors() const { return consoleColors; }
+        bool isConsoleSplitStderr() const { return consoleSplitStderr; }
+        LogLevel getConsoleStderrLevel() const { return consoleStderrLevel; }
+        long long getConsoleFlushIntervalMs() const { return consoleFlushIntervalMs; }
         bool isColorsEnabled() const { return enableColors; }
         bool isTimestampEnabled() const { return enableTimestamp; }
         const std::string& getDateTimeFormat() const { return dateTimeFormat; }
+        bool isSanitizeMessagesEnabled() const { return sanitizeMessages; }
         bool isAutoFlushEnabled() const { return autoFlush; }
 
         //Setters:
-        void setLogDirectory(const std::string& dir) { logDirectory = dir; }
-        void setFormatStyle(FormatStyle style) { formatStyle = style; }
-        void setMinLogLevel(LogLevel level) { minLogLevel = level; }
-        void setMaxFileSize(size_t size) { maxFileSize = size; }
-        void setMaxBackupFiles(int count) { maxBackupFiles = count; }
-        void setColorsEnabled(bool enabled) { enableColors = enabled; }
-        void setTimestampEnabled(bool enabled) { enableTimestamp = enabled; }
-        void setDateTimeFormat(const std::string& format) { dateTimeFormat = format; }
-        void setAutoFlushEnabled(bool enabled) { autoFlush = enabled; }
+        void setLogDirectory(const std::string& dir) { set(&Config::logDirectory, dir); }
+        void setFormatStyle(FormatStyle style) { set(&Config::formatStyle, style); }
+        void setMinLogLevel(LogLevel level) { set(&Config::minLogLevel, level); }
+        void setMaxFileSize(size_t size) { set(&Config::maxFileSize, size); }
+        void setMaxBackupFiles(int count) { set(&Config::maxBackupFiles, count); }
+        void setRotationInterval(long long seconds) { set(&Config::rotationInterval, seconds); }
+        void setCompressRotated(CompressionCodec codec) { set(&Config::compressRotated, codec); }
+        void setFileShardingEnabled(bool enabled) { set(&Config::fileSharding, enabled); }
+        void setIoUringEnabled(bool enabled) { set(&Config::ioUring, enabled); }
+        void setIoUringBuffers(size_t buffers) { set(&Config::ioUringBuffers, buffers); }
+        void setPayloadMaxBytes(size_t bytes) { set(&Config::payloadMaxBytes, bytes); }
+        void setBinaryFormat(bool binary) { set(&Config::binaryFormat, binary); }
+        void setShmRingEnabled(bool enabled) { set(&Config::shmRing, enabled); }
+        void setShmRingPrefix(const std::string& prefix) { set(&Config::shmRingPrefix, prefix); }
+        void setShmRingSlots(size_t slots) { set(&Config::shmRingSlots, slots); }
+        void setBinaryBlockRecords(size_t records) { set(&Config::binaryBlockRecords, records); }
+        void setBinaryBlockBytes(size_t bytes) { set(&Config::binaryBlockBytes, bytes); }
+        void setBinaryBlockIntervalMs(long long ms) { set(&Config::binaryBlockIntervalMs, ms); }
+        void setTimeIndexEnabled(bool enabled) { set(&Config::timeIndex, enabled); }
+        void setTimeIndexRecords(size_t records) { set(&Config::timeIndexRecords, records); }
+        void setTimeIndexBytes(size_t bytes) { set(&Config::timeIndexBytes, bytes); }
+        void setStreamCompression(CompressionCodec codec) { set(&Config::streamCompression, codec); }
+        void setCompressionFrameSize(size_t size) { set(&Config::compressionFrameSize, size); }
+        void setCompressionFrameIntervalMs(long long ms) { set(&Config::compressionFrameIntervalMs, ms); }
+        void setMaxFileSizeCompressed(bool compressed) { set(&Config::maxFileSizeCompressed, compressed); }
+        void setClockSource(ClockSource source) { set(&Config::clockSource, source); }
+        void setTscCalibrationMs(long long ms) { set(&Config::tscCalibrationMs, ms); }
+        void setAsyncLogging(bool enabled) { set(&Config::asyncLogging, enabled); }
+        void setAsyncWorkers(size_t workers) { set(&Config::asyncWorkers, workers); }
+        void setAsyncQueueRecords(size_t records) { set(&Config::asyncQueueRecords, records); }
+        void setAsyncQuantum(size_t records) { set(&Config::asyncQuantum, records); }
+        void setAsyncIdleMs(long long ms) { set(&Config::asyncIdleMs, ms); }
+        void setBacktraceSize(size_t records) { set(&Config::backtraceSize, records); }
+        void setBacktraceTriggerLevel(LogLevel level) { set(&Config::backtraceTriggerLevel, level); }
+        void setCrashHandlerEnabled(bool enabled) { set(&Config::crashHandler, enabled); }
+        void setCrashBacktraceEnabled(bool enabled) { set(&Config::crashBacktrace, enabled); }
+        void setForkSafe(bool enabled) { set(&Config::forkSafe, enabled); }
+        void setForkPidSuffix(bool enabled) { set(&Config::forkPidSuffix, enabled); }
+        void setWatchConfig(bool enabled) { set(&Config::watchConfig, enabled); }
+        void setWatchDebounceMs(long long ms) { set(&Config::watchDebounceMs, ms); }
+        void setMemoryBudget(size_t bytes) { set(&Config::memoryBudget, bytes); }
+        void setMemoryFlushPercent(size_t percent) { set(&Config::memoryFlushPercent, percent); }
+        void setMemoryShedLevel(LogLevel level) { set(&Config::memoryShedLevel, level); }
+        void setSocketPath(const std::string& path) { set(&Config::socketPath, path); }
+        void setSocketStream(bool stream) { set(&Config::socketStream, stream); }
+        void setSocketBufferBytes(size_t bytes) { set(&Config::socketBufferBytes, bytes); }
+        void setConsoleColors(ConsoleColors mode) { set(&Config::consoleColors, mode); }
+        void setConsoleSplitStderr(bool split) { set(&Config::consoleSplitStderr, split); }
+        void setConsoleStderrLevel(LogLevel level) { set(&Config::consoleStderrLevel, level); }
+        void setConsoleFlushIntervalMs(long long ms) { set(&Config::consoleFlushIntervalMs, ms); }
+        void setColorsEnabled(bool enabled) { set(&Config::enableColors, enabled); }
+        void setTimestampEnabled(bool enabled) { set(&Config::enableTimestamp, enabled); }
+        void setDateTimeFormat(const std::string& format) { set(&Config::dateTimeFormat, format); }
+        void setSanitizeMessagesEnabled(bool enabled) { set(&Config::sanitizeMessages, enabled); }
+        void setAutoFlushEnabled(bool enabled) { set(&Config::autoFlush, enabled); }
 
         // Color setters
-        void setTraceColor(const std::string& color) { colors.trace = color; }
-        void setDebugColor(const std::string& color) { colors.debug = color; }
-        void setInfoColor(const std::string& color) { colors.info = color; }
-        void setWarnColor(const std::string& color) { colors.warn = color; }
-        void setErrorColor(const std::string& color) { colors.error = color; }
-        void setFatalColor(const std::string& color) { colors.fatal = color; }
+        void setTraceColor(const std::string& color) { setColor(&LogLevelColors::trace, color); }
+        void setDebugColor(const std::string& color) { setColor(&LogLevelColors::debug, color); }
+        void setInfoColor(const std::string& color) { setColor(&LogLevelColors::info, color); }
+        void setWarnColor(const std::string& color) { setColor(&LogLevelColors::warn, color); }
+        void setErrorColor(const std::string& color) { setColor(&LogLevelColors::error, color); }
+        void setFatalColor(const std::string& color) { setColor(&LogLevelColors::fatal, color); }
 
         // Utility methods
-        void reloadConfig();
+        // Parses the config file into a copy of these settings and, if it
+        // validates, publishes the copy: getInstance() and every logger see
+        // all of the new values at once. Otherwise reports why on stderr,
+        // keeps the current settings and returns false.
+        bool reloadConfig();
         void saveConfig(const std::string& filepath = "");
         void printCurrentConfig() const;
     };
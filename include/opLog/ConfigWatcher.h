@@ -0,0 +1,56 @@
+#ifndef CONFIGWATCHER_H
+#define CONFIGWATCHER_H
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// Reloads the config file when it changes (watch_config). A thread watches
+// the file's directory with inotify, so editors that save by renaming a new
+// file over the old one are seen too, and waits until watch_debounce_ms
+// pass without another event before calling Config::reloadConfig(). The
+// file is parsed and validated on this thread and published in one swap;
+// logging threads never wait for it, and records already being written
+// finish with the settings they started with.
+class ConfigWatcher {
+private:
+    std::mutex mutex_;
+    std::thread thread_;
+    std::string path_;
+    long long debounceMs_{250};
+    int inotifyFd_{-1};
+    int wakeFd_{-1}; // eventfd that stops the thread
+    std::atomic<std::uint64_t> applied_{0};
+    std::atomic<std::uint64_t> rejected_{0};
+
+    ConfigWatcher() = default;
+
+    void run(int inotifyFd, int wakeFd, std::string path, long long debounceMs);
+    void stopLocked();
+    bool startLocked(const std::string& path, long long debounceMs);
+
+public:
+    ~ConfigWatcher();
+
+    ConfigWatcher(const ConfigWatcher&) = delete;
+    ConfigWatcher& operator=(const ConfigWatcher&) = delete;
+
+    static ConfigWatcher& getInstance();
+
+    // Watches `path`, moving a running watcher over if it watches another
+    // file; false if inotify is not available
+    bool start(const std::string& path, long long debounceMs);
+    void stop();
+    bool isRunning();
+
+    std::uint64_t appliedReloads() const { return applied_.load(std::memory_order_relaxed); }
+    std::uint64_t rejectedReloads() const { return rejected_.load(std::memory_order_relaxed); }
+
+    // The child of a fork() starts a watcher of its own
+    void prepareFork();
+    void afterFork(bool child);
+};
+
+#endif //CONFIGWATCHER_H
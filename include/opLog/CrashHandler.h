@@ -0,0 +1,37 @@
+#ifndef CRASHHANDLER_H
+#define CRASHHANDLER_H
+
+#include <cstddef>
+
+class IAppender;
+
+// Opt-in (crash_handler=true) last-gasp flush for fatal signals (SIGSEGV,
+// SIGABRT, SIGBUS, SIGFPE) and std::terminate.
+// Every appender owned by a Logger is registered here. On a crash each one
+// gets IAppender::emergencyFlush(), which writes whatever it still buffers
+// with async-signal-safe calls only; a marker line (and, with
+// crash_backtrace=true, the raw backtrace) then follows on the fds they
+// report and on stderr. The previous handler is restored and the signal
+// re-raised, so core dumps and exit statuses are unchanged.
+// Records an async Logger has queued but not yet handed to its appenders are
+// not covered: turning them into text needs allocation and locks.
+class CrashHandler {
+public:
+    static constexpr std::size_t kMaxAppenders = 64;
+
+    // Idempotent; later calls only update the backtrace setting
+    static void install(bool backtrace);
+
+    // Lock-free, safe to call while a crash is being handled
+    static void registerAppender(IAppender* appender) noexcept;
+    static void unregisterAppender(IAppender* appender) noexcept;
+
+    // Flushes every registered appender and writes the marker. Only the
+    // first call does anything.
+    static void emergencyFlush(const char* reason) noexcept;
+
+    // write(2) loop for emergencyFlush() implementations
+    static void writeAll(int fd, const char* data, std::size_t size) noexcept;
+};
+
+#endif //CRASHHANDLER_H
@@ -0,0 +1,44 @@
+#ifndef FORKHANDLER_H
+#define FORKHANDLER_H
+
+#include <new>
+#include <utility>
+
+class Logger;
+
+// pthread_atfork integration, installed by the first Logger.
+// Before fork() every live Logger drains its async queue and flushes its
+// appenders, then all logging locks are taken (Config's, each logger's and
+// appender's, the list of open files', the worker pool's, the rotation
+// worker's, the config watcher's) so that none is
+// held mid-operation by a thread that will not exist in the child. The
+// parent simply releases them. The child releases them too, forgets the
+// threads that did not survive the fork (restarting the ones it needs),
+// drops work that the parent still owns, reconnects sockets and reopens
+// log files; with fork_pid_suffix=true under a per-PID name such as
+// 2024-01-15-log.p4242.txt, so parent and children never share a file.
+class ForkHandler {
+public:
+    static void install();
+
+    static void registerLogger(Logger* logger);
+    static void unregisterLogger(Logger* logger);
+
+    // In the child: replace an object that the parent's threads left in a
+    // state only they could undo (a handle to a thread that is gone, a
+    // condition variable with waiters that are gone, an atomic shared_ptr
+    // locked mid-load) with a fresh one. The old object is not destroyed;
+    // its destructor could block or terminate.
+    template<typename T, typename... Args>
+    static void reinitialize(T& object, Args&&... args) noexcept {
+        new (&object) T(std::forward<Args>(args)...);
+    }
+
+private:
+    static void prepare();
+    static void parent();
+    static void child();
+    static void release(bool child);
+};
+
+#endif //FORKHANDLER_H
@@ -0,0 +1,118 @@
+#ifndef LOGDISPATCHER_H
+#define LOGDISPATCHER_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "LogRecord.h"
+#include "MemoryBudget.h"
+
+class LogDispatcher;
+
+// Queue of records from one async Logger, consumed by the shared
+// LogDispatcher pool. A channel is scheduled at most once at a time, so
+// only one worker ever runs it and the logger's records stay in order.
+class LogChannel : public std::enable_shared_from_this<LogChannel> {
+public:
+    using Consumer = std::function<void(const LogRecord&)>;
+
+    LogChannel(LogDispatcher& dispatcher, Consumer consumer, std::size_t capacity);
+
+    // Blocks while async_queue_records records are already waiting
+    void push(LogRecord record);
+    // Never waits: false (and the record is not queued) when full
+    bool tryPush(LogRecord record);
+    // Returns once every record pushed so far has been consumed
+    void drain();
+    // Runs `then` on a pool thread once every record pushed so far has
+    // been consumed
+    void whenDrained(std::function<void()> then);
+
+    // Held across fork(); the child drops records the parent still owns
+    void prepareFork();
+    void afterFork(bool child);
+
+private:
+    friend class LogDispatcher;
+
+    LogDispatcher& dispatcher_;
+    Consumer consumer_;
+    std::size_t capacity_;
+
+    std::mutex mutex_;
+    std::condition_variable changed_;
+    std::deque<LogRecord> queue_;
+    MemoryBudget::Account queued_; // Queued records, until consumed
+    std::uint64_t pushed_{0};
+    std::uint64_t consumed_{0};
+    std::deque<std::pair<std::uint64_t, std::function<void()>>> barriers_; // (pushed_ when added, then)
+    bool scheduled_{false}; // Queued in the pool or being run
+
+    // Under mutex_; true if the caller must hand the channel to the pool
+    bool markScheduled();
+
+    // Consumes up to `quantum` records; true if the channel has more and
+    // stays scheduled
+    bool run(std::size_t quantum, std::vector<LogRecord>& batch);
+};
+
+// Worker pool shared by every async Logger (async_workers threads at most).
+// Channels with pending records sit in per-worker run queues; a worker
+// serves its own queue round-robin, async_quantum records per turn so a
+// chatty logger cannot starve the others, and steals from the other
+// queues when its own is empty. Workers start on demand and exit after
+// async_idle_ms without work.
+class LogDispatcher {
+private:
+    struct Worker {
+        std::mutex mutex;
+        std::deque<std::shared_ptr<LogChannel>> runQueue;
+        std::thread thread;
+        bool running{false};
+    };
+
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::size_t quantum_;
+    std::chrono::milliseconds idle_;
+
+    std::atomic<std::size_t> nextWorker_{0};
+    std::atomic<std::size_t> pending_{0}; // Channels waiting in run queues
+    std::mutex sleepMutex_;
+    std::condition_variable wake_;
+    bool stop_{false};
+
+    void runWorker(std::size_t index);
+    std::shared_ptr<LogChannel> take(std::size_t index);
+    void enqueue(std::size_t index, std::shared_ptr<LogChannel> channel);
+
+public:
+    LogDispatcher(std::size_t workers, std::size_t quantum, std::chrono::milliseconds idle);
+    ~LogDispatcher();
+
+    LogDispatcher(const LogDispatcher&) = delete;
+    LogDispatcher& operator=(const LogDispatcher&) = delete;
+
+    // The process-wide pool, created from Config on first use. Loggers
+    // hold a reference so it outlives them at exit.
+    static std::shared_ptr<LogDispatcher> shared();
+
+    void schedule(std::shared_ptr<LogChannel> channel);
+
+    std::size_t runningWorkers();
+
+    // Around fork(), for the pool if there is one. The child starts with
+    // no workers and no queued channels; workers start again on demand.
+    static void prepareFork();
+    static void afterFork(bool child);
+};
+
+#endif //LOGDISPATCHER_H
@@ -4,11 +4,13 @@
 #include <chrono>
 #include <string>
 #include "LogLevel.h"
+#include "Payload.h"
 
 struct LogRecord {
     LogLevel logLevel;
     std::string message;
     std::chrono::system_clock::time_point timestamp;
+    Payload payload{}; // Empty unless logged with one
 };
 
 
@@ -1,6 +1,9 @@
 #ifndef LOGGER_H
 #define LOGGER_H
 
+#include <atomic>
+#include <coroutine>
+#include <functional>
 #include <memory>
 #include <vector>
 #include <mutex>
@@ -8,11 +11,77 @@
 #include "appender/IAppender.h"
 #include "LogLevel.h"
 
+class BacktraceRing;
+class LogChannel;
+class LogDispatcher;
+class Logger;
+
+// What Logger::flushAsync() returns: co_await it to suspend until every
+// record logged before the call is written and flushed
+class FlushAwaitable {
+public:
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(std::coroutine_handle<> handle) const;
+    void await_resume() const noexcept {}
+
+private:
+    friend class Logger;
+    explicit FlushAwaitable(const Logger& logger) : logger_(logger) {}
+    const Logger& logger_;
+};
+
 class Logger {
+public:
+    // Resumes a coroutine suspended in flushAsync(), e.g. by posting it to
+    // an event loop. Called on a pool thread.
+    using Executor = std::function<void(std::coroutine_handle<>)>;
+
 private:
-    std::unique_ptr<IFormatter> formatter_;
-    std::vector<std::unique_ptr<IAppender>> appenders_;
-    mutable std::mutex logMutex_; // For thread safety
+    struct AppenderSlot {
+        std::unique_ptr<IAppender> appender;
+        mutable std::mutex mutex; // Serializes appenders that are not thread-safe
+    };
+
+    // The formatter and appenders are published together as an immutable
+    // snapshot. log() loads it without taking a lock; changes copy the
+    // snapshot and swap it in, and an old one is freed when the last call
+    // still using it drops its reference.
+    struct Snapshot {
+        std::shared_ptr<IFormatter> formatter;
+        std::vector<std::shared_ptr<AppenderSlot>> appenders;
+        Executor executor;
+    };
+
+    std::atomic<std::shared_ptr<const Snapshot>> snapshot_;
+    std::mutex updateMutex_; // Serializes copy-and-swap updates
+    std::shared_ptr<const Snapshot> forkSnapshot_; // Its slots stay locked across fork()
+
+    // Records below min_log_level, replayed on a trigger record (null if off)
+    std::unique_ptr<BacktraceRing> backtrace_;
+    LogLevel backtraceTrigger_{LogLevel::ERROR};
+    mutable std::mutex backtraceMutex_; // One replay at a time
+
+    // Channel on the shared pool. With async_logging every record goes
+    // through it; otherwise only tryLog() records and flushAsync() do.
+    std::shared_ptr<LogDispatcher> dispatcher_;
+    std::shared_ptr<LogChannel> channel_;
+    bool async_{false};
+
+    template<typename Update>
+    void updateSnapshot(Update&& update);
+    void writeRecord(const LogRecord& record) const;
+    static void writeToAppenders(const Snapshot& snapshot, const LogRecord& record, const std::string& formatted);
+    void writeBacktrace(const Snapshot& snapshot) const;
+    void flushAppenders() const;
+
+    friend class FlushAwaitable;
+    void resumeWhenFlushed(std::coroutine_handle<> handle) const;
+
+    // Called by ForkHandler after flush(): take every lock, then release
+    // them in the parent or reset the state the child inherited
+    friend class ForkHandler;
+    void prepareFork();
+    void afterFork(bool child);
 
     // Static instance for singleton pattern
     static std::unique_ptr<Logger> instance_;
@@ -22,6 +91,7 @@ public:
     // Constructor for custom logger
     Logger(std::unique_ptr<IFormatter> formatter = nullptr,
            std::vector<std::unique_ptr<IAppender>> appenders = {});
+    ~Logger();
 
     // Explicitly delete copy and move constructors/assignment operators
     Logger(const Logger&) = delete;
@@ -37,6 +107,16 @@ public:
 
     // Core logging method
     void log(LogLevel level, const std::string& message) const;
+    // `payload` is written after the formatted line, cut to
+    // payload_max_bytes. A borrowed payload is copied only when the record
+    // is queued for async_logging; the held backtrace keeps just the message.
+    void log(LogLevel level, const std::string& message, Payload payload) const;
+
+    // For event-loop threads: queues the record for the pool and returns
+    // without waiting on appenders or a full queue; false if the record was
+    // dropped because async_queue_records are already waiting. On a logger
+    // without async_logging these records are not ordered with log() calls.
+    bool tryLog(LogLevel level, std::string message) const;
 
     // Convenience methods
     void trace(const std::string& message) const;
@@ -44,7 +124,7 @@ public:
     void info(const std::string& message) const;
     void warn(const std::string& message) const;
     void error(const std::string& message) const;
-    void fatal(const std::string& message) const;
+    void fatal(const std::string& message) const; // Flushes before returning
 
     // Formatted logging (printf-style)
     template<typename... Args>
@@ -66,11 +146,22 @@ public:
 
     // Configuration
     void setFormatter(std::unique_ptr<IFormatter> formatter);
-    void reloadConfig();
+    // Config::reloadConfig(). Levels and formatting apply to the next
+    // record, rotation and console settings on each appender's next write;
+    // the choice of appenders, async_logging and the clock stay as built.
+    bool reloadConfig();
 
     // Utility methods
     bool shouldLog(LogLevel level) const;
-    void flush() const; // Force flush all appenders
+    void flush() const; // Wait for queued records, then flush all appenders
+    void dumpBacktrace() const; // Write out the backtrace ring now
+
+    // Coroutine counterpart of flush(): `co_await logger.flushAsync();`
+    // resumes once every earlier record is written and the appenders are
+    // flushed, through the executor if one is set, otherwise directly on
+    // the pool thread (which must then not call flush()).
+    FlushAwaitable flushAsync() const { return FlushAwaitable(*this); }
+    void setExecutor(Executor executor);
 };
 
 // Template implementations
@@ -79,7 +170,7 @@ public:
 
 template<typename... Args>
 void Logger::logf(LogLevel level, const std::string& format, Args&&... args) const {
-    if (!shouldLog(level)) return;
+    if (!shouldLog(level) && !backtrace_) return;
 
     // Simple sprintf-style formatting
     char buffer[1024];
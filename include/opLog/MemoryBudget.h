@@ -0,0 +1,90 @@
+#ifndef MEMORYBUDGET_H
+#define MEMORYBUDGET_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include "LogLevel.h"
+
+// Process-wide account of the memory opLog holds: records queued for async
+// loggers or kept in backtrace rings, lines being formatted and written, and
+// appender buffers. Charges land on one of kShards cache-line-sized counters
+// picked per thread, which is folded into the total once it is kShardSlack
+// bytes away from it; charging is one uncontended atomic add, and the total
+// the budget checks read is at most kShards * kShardSlack bytes stale.
+//
+// With memory_budget set Logger degrades as usage grows: past
+// memory_flush_percent of the budget every record is flushed through and
+// appender buffers are given back, and at the budget records below
+// memory_shed_level are dropped (and counted) before they are stored.
+// Records at memory_shed_level and above are always kept.
+class MemoryBudget {
+public:
+    enum class Pressure { NORMAL, FLUSH, SHED };
+
+    struct Usage {
+        std::size_t current;
+        std::size_t peak;
+        std::size_t limit; // 0 = no budget
+        std::uint64_t shedRecords;
+    };
+
+    // Memory held by one object, charged as it changes and released with it
+    class Account {
+    private:
+        std::size_t bytes_{0};
+
+    public:
+        Account() = default;
+        explicit Account(std::size_t bytes) { set(bytes); }
+        ~Account() { set(0); }
+
+        Account(const Account&) = delete;
+        Account& operator=(const Account&) = delete;
+
+        void set(std::size_t bytes) {
+            if (bytes != bytes_) {
+                add(static_cast<std::int64_t>(bytes) - static_cast<std::int64_t>(bytes_));
+                bytes_ = bytes;
+            }
+        }
+        std::size_t bytes() const { return bytes_; }
+    };
+
+    static void charge(std::size_t bytes) { add(static_cast<std::int64_t>(bytes)); }
+    static void release(std::size_t bytes) { add(-static_cast<std::int64_t>(bytes)); }
+
+    static Pressure pressure();
+    // False if a record at `level` is to be shed; counts it
+    static bool admit(LogLevel level);
+
+    // `current` is exact; `peak` is tracked on the folded total
+    static Usage usage();
+    static void resetPeak();
+
+private:
+    static constexpr std::size_t kShards = 16;
+    static constexpr std::int64_t kShardSlack = 16 * 1024;
+
+    struct alignas(64) Shard {
+        std::atomic<std::int64_t> pending{0};
+    };
+
+    static Shard shards_[kShards];
+    static std::atomic<std::int64_t> total_;
+    static std::atomic<std::int64_t> peak_;
+    static std::atomic<std::uint64_t> shed_;
+
+    static Shard& shard();
+    static void fold(Shard& shard);
+
+    static void add(std::int64_t delta) {
+        Shard& own = shard();
+        const std::int64_t pending = own.pending.fetch_add(delta, std::memory_order_relaxed) + delta;
+        if (pending >= kShardSlack || pending <= -kShardSlack) {
+            fold(own);
+        }
+    }
+};
+
+#endif //MEMORYBUDGET_H
@@ -0,0 +1,68 @@
+#ifndef PAYLOAD_H
+#define PAYLOAD_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+// Bytes attached to a record (a request body, a packet) that are written
+// after the formatted line instead of being built into the message, so a
+// several-hundred-KB body is never copied into LogRecord::message or through
+// the formatter. Appenders that can (FileAppender, IoUringFileAppender)
+// write the line and the payload with one writev(); the others get the
+// payload rendered onto the end of the line.
+//
+// The bytes are either borrowed, in which case they must stay valid until
+// log() returns (an async logger copies them when it queues the record), or
+// shared, kept alive by a shared_ptr for as long as any record needs them.
+class Payload {
+public:
+    enum class Encoding : std::uint8_t {
+        RAW,    // As is: for text bodies
+        HEX,    // Two lowercase digits per byte
+        BASE64, // RFC 4648, padded
+    };
+
+    Payload() = default;
+
+    static Payload borrow(const void* data, std::size_t size, Encoding encoding = Encoding::HEX);
+    static Payload share(std::shared_ptr<const void> owner, const void* data, std::size_t size,
+                         Encoding encoding = Encoding::HEX);
+    static Payload share(std::shared_ptr<const std::string> bytes, Encoding encoding = Encoding::HEX);
+
+    // Keeps the first `maxBytes`; the line then says how many were left out
+    Payload& truncate(std::size_t maxBytes);
+    // A shared payload owning a copy of borrowed bytes
+    Payload shared() const;
+
+    explicit operator bool() const { return data_ != nullptr; }
+    const unsigned char* data() const { return data_; }
+    std::size_t size() const { return size_; }
+    std::size_t omitted() const { return omitted_; }
+    Encoding encoding() const { return encoding_; }
+    bool isBorrowed() const { return data_ != nullptr && !owner_; }
+
+    std::size_t renderedSize() const;
+    // Writes renderedSize() bytes to `out`
+    void render(char* out) const;
+    // " (+N bytes)" after a truncated payload, otherwise empty
+    std::string note() const;
+    // Appends a space, the rendered payload and the note
+    void appendTo(std::string& line) const;
+
+    // SSE2 for hex and SSSE3 (when the CPU has it) for base64 on x86-64,
+    // scalar elsewhere
+    static void encodeHex(const unsigned char* data, std::size_t size, char* out);
+    static void encodeBase64(const unsigned char* data, std::size_t size, char* out);
+    static std::size_t base64Size(std::size_t size) { return (size + 2) / 3 * 4; }
+
+private:
+    std::shared_ptr<const void> owner_;
+    const unsigned char* data_{nullptr};
+    std::size_t size_{0};
+    std::size_t omitted_{0};
+    Encoding encoding_{Encoding::HEX};
+};
+
+#endif //PAYLOAD_H
@@ -0,0 +1,100 @@
+#ifndef TIMESOURCE_H
+#define TIMESOURCE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <time.h>
+#include "ClockSource.h"
+#if defined(__x86_64__)
+#include <x86intrin.h>
+#endif
+
+// Where LogRecord timestamps come from (clock_source in opLog.conf).
+//
+// TSC mode reads the CPU timestamp counter and scales it to wall time with
+// a (base, multiplier) pair that a background thread recalibrates against
+// CLOCK_REALTIME every tsc_calibration_ms; readers pick the pair up through
+// a seqlock, so now() is an rdtsc plus a multiply-shift, with no syscall.
+// A recalibration never moves the time back: when the clock already reads
+// ahead of CLOCK_REALTIME it runs slower until the next round instead.
+// TSC mode needs an invariant TSC (x86-64); elsewhere it falls back to the
+// coarse clock.
+class TimeSource {
+public:
+    using TimePoint = std::chrono::system_clock::time_point;
+
+    // Switches the process-wide source; starts, restarts or stops the
+    // calibration thread. Config calls this when clock_source or
+    // tsc_calibration_ms changes; a source selected here directly stays
+    // until they do.
+    static void select(ClockSource source, long long calibrationMs = 1000);
+    static ClockSource current() { return mode_.load(std::memory_order_relaxed); }
+    static bool tscAvailable();
+
+    // Around fork(); the child restarts the calibration thread
+    static void prepareFork();
+    static void afterFork(bool child);
+
+    static TimePoint now() {
+        switch (mode_.load(std::memory_order_relaxed)) {
+            case ClockSource::COARSE: return coarseNow();
+            case ClockSource::TSC: return tscNow();
+            case ClockSource::PRECISE: break;
+        }
+        return std::chrono::system_clock::now();
+    }
+
+private:
+    static std::atomic<ClockSource> mode_;
+
+    // Calibration, published under seq_ (odd while being updated)
+    static std::atomic<std::uint64_t> seq_;
+    static std::atomic<std::uint64_t> baseTicks_;
+    static std::atomic<std::int64_t> baseNs_;
+    static std::atomic<std::uint64_t> nsPerTick_; // 32.32 fixed point
+
+    friend class TscCalibrator;
+
+    // Wall time of `ticks` under the calibration (baseTicks, baseNs, nsPerTick)
+    static std::int64_t project(std::uint64_t baseTicks, std::int64_t baseNs, std::uint64_t nsPerTick,
+                                std::uint64_t ticks) {
+        const auto delta = static_cast<std::int64_t>(ticks - baseTicks); // May be slightly negative
+        const auto scaled = static_cast<__int128>(delta) * static_cast<__int128>(nsPerTick);
+        return baseNs + static_cast<std::int64_t>(scaled >> 32);
+    }
+
+    static TimePoint fromNs(std::int64_t ns) {
+        return TimePoint(std::chrono::duration_cast<TimePoint::duration>(std::chrono::nanoseconds(ns)));
+    }
+
+    static TimePoint coarseNow() {
+        timespec ts{};
+        ::clock_gettime(CLOCK_REALTIME_COARSE, &ts);
+        return fromNs(static_cast<std::int64_t>(ts.tv_sec) * 1000000000LL + ts.tv_nsec);
+    }
+
+    static TimePoint tscNow() {
+#if defined(__x86_64__)
+        std::uint64_t seq;
+        std::uint64_t baseTicks;
+        std::int64_t baseNs;
+        std::uint64_t nsPerTick;
+        std::uint64_t ticks;
+        do {
+            seq = seq_.load(std::memory_order_acquire);
+            baseTicks = baseTicks_.load(std::memory_order_relaxed);
+            baseNs = baseNs_.load(std::memory_order_relaxed);
+            nsPerTick = nsPerTick_.load(std::memory_order_relaxed);
+            ticks = __rdtsc(); // Before the re-check: a reading taken after a publish began is retried
+            std::atomic_thread_fence(std::memory_order_acquire);
+        } while ((seq & 1) != 0 || seq != seq_.load(std::memory_order_relaxed));
+
+        return fromNs(project(baseTicks, baseNs, nsPerTick, ticks));
+#else
+        return coarseNow();
+#endif
+    }
+};
+
+#endif //TIMESOURCE_H
@@ -0,0 +1,65 @@
+#ifndef BINARYFILEAPPENDER_H
+#define BINARYFILEAPPENDER_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "IAppender.h"
+#include "RollingFile.h"
+
+// Writes records in the block-structured binary format described in
+// opLog/binary/BinaryLogFormat.h (e.g. 2024-01-15-log.oplb) instead of text.
+// The formatted message is ignored: timestamp, level and the raw message
+// are stored, so no timestamp text or color codes end up on disk.
+// Records are buffered until a block holds binary_block_records records or
+// binary_block_bytes of messages, or its oldest record is
+// binary_block_interval_ms old; auto_flush applies to completed blocks.
+class BinaryFileAppender final : public IAppender {
+private:
+    RollingFile file_;
+    size_t blockRecords_;
+    size_t blockBytes_;
+    std::chrono::milliseconds blockInterval_;
+    std::chrono::steady_clock::time_point blockSince_;
+
+    // Block under construction
+    std::vector<long long> timestamps_;
+    std::string levels_;
+    std::vector<std::uint32_t> messageIds_;
+    std::unordered_map<std::string, std::uint32_t> dictionary_;
+    std::vector<const std::string*> dictionaryOrder_;
+    size_t dictionaryBytes_{0};
+    std::string encoded_;
+    MemoryBudget::Account memory_; // The open block and encoded_
+
+    // Age-based block flushes run on a timer thread
+    std::mutex mutex_;
+    std::condition_variable timerCv_;
+    std::thread timer_;
+    bool stop_{false};
+
+    void trackMemory();
+
+    void flushBlock();
+    void runTimer();
+
+public:
+    BinaryFileAppender();
+    ~BinaryFileAppender() override;
+
+    void write(const std::string& message) override;
+    void write(const LogRecord& record, const std::string& message) override;
+    bool isThreadSafe() const override { return true; }
+    void flush() override;
+    // Completed blocks only: encoding the open one is not signal-safe
+    int emergencyFlush() noexcept override;
+    void prepareFork() override;
+    void afterFork(bool child) override;
+};
+
+#endif //BINARYFILEAPPENDER_H
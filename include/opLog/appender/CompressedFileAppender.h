@@ -0,0 +1,56 @@
+#ifndef COMPRESSEDFILEAPPENDER_H
+#define COMPRESSEDFILEAPPENDER_H
+
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include "IAppender.h"
+#include "RollingFile.h"
+#include "opLog/MemoryBudget.h"
+#include "opLog/compression/Compressor.h"
+
+// Rotating file appender that compresses on the fly.
+// Records are collected into frames of up to compression_frame_size bytes
+// (or compression_frame_interval_ms of age) and each frame is written as an
+// independent gzip member / zstd frame, e.g. 2024-01-15-log.txt.gz.
+// The file can be tailed with zcat and survives a crash up to the last
+// complete frame. Frames never straddle a rotation.
+class CompressedFileAppender final : public IAppender {
+private:
+    std::unique_ptr<FrameEncoder> encoder_; // null when no codec is built in
+    RollingFile file_;
+    std::string pending_;
+    std::string frame_;
+    MemoryBudget::Account memory_; // pending_ and frame_
+    std::chrono::steady_clock::time_point pendingSince_;
+    size_t frameSize_;
+    std::chrono::milliseconds frameInterval_;
+    bool countCompressed_;
+
+    // Age-based frame flushes run on a timer thread
+    std::mutex mutex_;
+    std::condition_variable timerCv_;
+    std::thread timer_;
+    bool stop_{false};
+
+    void flushFrame();
+    void runTimer();
+
+public:
+    CompressedFileAppender();
+    ~CompressedFileAppender() override;
+
+    void write(const std::string& message) override;
+    void write(const LogRecord& record, const std::string& message) override;
+    bool isThreadSafe() const override { return true; }
+    void flush() override;
+    // Complete frames go to the file; the open frame cannot be compressed in
+    // a signal handler, so it is written as text to <file>.crash
+    int emergencyFlush() noexcept override;
+    void prepareFork() override;
+    void afterFork(bool child) override;
+};
+
+#endif //COMPRESSEDFILEAPPENDER_H
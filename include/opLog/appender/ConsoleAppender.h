@@ -1,14 +1,58 @@
 #ifndef CONSOLE_APPENDER_H
 #define CONSOLE_APPENDER_H
 
-#include <iostream>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
 #include "IAppender.h"
+#include "opLog/MemoryBudget.h"
 
 
+// Writes straight to fd 1 (and optionally fd 2 for WARN+) with its own
+// buffer, bypassing iostream. Color codes are stripped when the target is
+// not a terminal unless console_colors=always. With auto_flush off, output
+// is held at most console_flush_interval_ms before a timer writes it.
 class ConsoleAppender final : public IAppender {
+    private:
+    struct Stream {
+        int fd;
+        bool colors;
+        std::string buffer;
+        MemoryBudget::Account memory{}; // buffer's capacity
+    };
+
+    Stream out_;
+    Stream err_;
+    bool splitStderr_;
+    LogLevel stderrLevel_;
+    bool autoFlush_;
+    std::chrono::milliseconds flushInterval_{0};
+    std::chrono::steady_clock::time_point bufferedSince_; // Oldest unwritten byte
+    unsigned configGeneration_{0}; // Settings are re-read after a config reload
+
+    // Age-based flushes run on a timer thread, started once output is held
+    std::mutex mutex_;
+    std::condition_variable timerCv_;
+    std::thread timer_;
+    bool stop_{false};
+
+    void loadSettings();
+    void append(Stream& stream, const std::string& message);
+    static void flushStream(Stream& stream);
+    void runTimer();
+
     public:
-    ConsoleAppender() = default;
+    ConsoleAppender();
+    ~ConsoleAppender() override;
     void write(const std::string& message) override;
+    void write(const LogRecord& record, const std::string& message) override;
+    bool isThreadSafe() const override { return true; }
+    void flush() override;
+    int emergencyFlush() noexcept override;
+    void prepareFork() override;
+    void afterFork(bool child) override;
 
 };
 
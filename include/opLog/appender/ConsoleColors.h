@@ -0,0 +1,10 @@
+#ifndef CONSOLECOLORS_H
+#define CONSOLECOLORS_H
+
+enum class ConsoleColors {
+    AUTO,   // Colors only when the stream is a terminal
+    ALWAYS,
+    NEVER,
+};
+
+#endif //CONSOLECOLORS_H
@@ -3,20 +3,27 @@
 
 
 #include "IAppender.h"
+#include "RollingFile.h"
+#include "TimeIndex.h"
 #include <iostream>
+#include <memory>
 
 class FileAppender final : public IAppender {
     private:
-        size_t currentFileSize;
-        std::string generateFileName(const std::string& message);
-        bool needsRotation(const std::string &filepath);
-
-        void rotateFile(const std::string &filepath);
+        RollingFile file_;
+        std::unique_ptr<TimeIndex> index_; // null unless time_index is enabled
+        unsigned indexedGeneration_{0};
 
     public:
     FileAppender();
     ~FileAppender() override = default;
     void write(const std::string& message) override;
+    void write(const LogRecord& record, const std::string& message) override;
+    bool writesPayloads() const override { return true; }
+    void flush() override;
+    int emergencyFlush() noexcept override;
+    void prepareFork() override;
+    void afterFork(bool child) override;
 };
 
 #endif //FILEAPPENDER_H
@@ -1,12 +1,44 @@
 #ifndef APPENDER_H
 #define APPENDER_H
 #include <string>
+#include "opLog/LogRecord.h"
 
 class IAppender {
 
 public:
     virtual ~IAppender() = default;
     virtual void write(const std::string& msg) = 0; //todo: add thread safety
+
+    // Record-aware write used by Logger. Appenders that need the record itself
+    // (timestamp, level) override this; the default forwards the formatted text.
+    virtual void write(const LogRecord& record, const std::string& msg) {
+        (void)record;
+        write(msg);
+    }
+
+    // True if write(record, msg) writes record.payload after the line itself.
+    // Otherwise Logger renders the payload onto the end of the message and
+    // the formatted line, and the appender never sees it.
+    virtual bool writesPayloads() const { return false; }
+
+    // Push any buffered output to the underlying sink.
+    virtual void flush() {}
+
+    // Logger serializes write() calls on an appender unless it returns true
+    // here, i.e. it does its own locking (flush() is always serialized).
+    virtual bool isThreadSafe() const { return false; }
+
+    // Called by CrashHandler from a fatal signal handler: write out whatever
+    // is still buffered using async-signal-safe calls only (no locks, no
+    // allocation). Returns the fd the crash marker should follow, or -1.
+    virtual int emergencyFlush() noexcept { return -1; }
+
+    // Called by ForkHandler around fork(), after flush() and with Logger's
+    // lock for this appender held. prepareFork() takes the appender's own
+    // locks; afterFork() releases them and, in the child, restarts
+    // background threads and drops state that belongs to the parent.
+    virtual void prepareFork() {}
+    virtual void afterFork(bool child) { (void)child; }
 };
 
 #endif //APPENDER_H
@@ -0,0 +1,42 @@
+#ifndef IOURINGFILEAPPENDER_H
+#define IOURINGFILEAPPENDER_H
+
+#include <memory>
+#include "IAppender.h"
+#include "RollingFile.h"
+
+class IoUringOutput;
+
+// FileAppender variant that hands its buffered bytes to the kernel through
+// io_uring instead of write(2), so the logging thread does not wait for a
+// slow or contended disk. Buffers are copied into a pool of io_uring_buffers
+// registered buffers and submitted with explicit file offsets; completions
+// are reaped without blocking on later submissions, and the writer only
+// waits when every buffer is in flight, on flush(), and before a rotation
+// renames the file. Rotation settings are the same as FileAppender's.
+// Without io_uring (old kernel, seccomp, kernel.io_uring_disabled) the same
+// buffers are written with pwrite(2) instead.
+class IoUringFileAppender final : public IAppender {
+private:
+    std::unique_ptr<IoUringOutput> output_; // Outlives file_, which finishes through it
+    RollingFile file_;
+
+public:
+    IoUringFileAppender();
+    ~IoUringFileAppender() override;
+
+    void write(const std::string& message) override;
+    void write(const LogRecord& record, const std::string& message) override;
+    bool writesPayloads() const override { return true; }
+    // Returns once everything written so far is in the file
+    void flush() override;
+    int emergencyFlush() noexcept override;
+    // A forked child sets up a ring of its own
+    void prepareFork() override;
+    void afterFork(bool child) override;
+
+    // False when running on the pwrite(2) fallback
+    bool usingIoUring() const;
+};
+
+#endif //IOURINGFILEAPPENDER_H
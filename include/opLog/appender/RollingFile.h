@@ -0,0 +1,116 @@
+#ifndef ROLLINGFILE_H
+#define ROLLINGFILE_H
+
+#include <atomic>
+#include <climits>
+#include <cstddef>
+#include <string>
+#include <sys/types.h>
+#include "opLog/MemoryBudget.h"
+#include "opLog/Payload.h"
+
+// An append-only log file that rolls over by time and size.
+// The file is named after the rotation period of the record that opens it
+// (e.g. 2024-01-15-log.txt for daily rotation), so the date never has to be
+// recovered from the formatted text. The per-record rotation check is a
+// single compare of the record timestamp against a precomputed deadline;
+// reaching max_file_size, or any change to the config (a setter or a
+// reload, see settingsChanged()), pulls that deadline forward to "now".
+class RollingFile {
+public:
+    // Replaces write(2) for appenders that hand bytes to the kernel some
+    // other way (IoUringFileAppender). Files are then opened without
+    // O_APPEND and every write carries its offset, so writes that complete
+    // out of order still land in order.
+    class Output {
+    public:
+        virtual ~Output() = default;
+        // Copies the bytes; they may reach the file later
+        virtual void write(int fd, const char* data, std::size_t size, off_t offset) = 0;
+        // Returns once every write to `fd` has reached the file
+        virtual void finish(int fd) = 0;
+        // Signal-safe: write out again whatever is still in flight
+        virtual void emergencyFlush() noexcept {}
+    };
+
+private:
+    static constexpr long long kRollNow = LLONG_MIN;
+    static constexpr std::size_t kBufferLimit = 64 * 1024;
+    static constexpr std::size_t kGatherLimit = 16 * 1024; // Smaller payloads are copied into the buffer
+
+    std::string suffix_;
+    std::string pidTag_; // ".p<pid>" in a forked child with fork_pid_suffix
+    std::string directory_;
+    std::string path_;
+    std::string buffer_;
+    std::string rendered_; // Hex/base64 of a payload too large for the buffer, or an escaped raw one
+    MemoryBudget::Account memory_; // buffer_ and rendered_
+    Output* output_;
+    int fd_{-1};
+    off_t offset_{0}; // Where the next byte goes, with an Output
+    std::size_t size_{0};
+    unsigned generation_{0}; // Bumped whenever a different file is opened
+    std::atomic<long long> nextRolloverNs_{kRollNow}; // Also pulled forward by settingsChanged()
+    long long periodEndNs_{kRollNow};
+
+    // Cached from Config, refreshed on every roll
+    unsigned configGeneration_{0};
+    std::size_t maxFileSize_{0};
+    long long interval_{0};
+    bool autoFlush_{true};
+    bool sanitize_{false}; // sanitize_messages, for raw payloads
+
+    void loadSettings();
+    void startPeriod(long long timestampNs);
+    void open(const std::string& path);
+    void close();
+    void flushBuffer();
+    void trackMemory() { memory_.set(buffer_.capacity() + rendered_.capacity()); }
+    void writeGathered(const char* payload, std::size_t payloadSize, const std::string& tail);
+
+public:
+    explicit RollingFile(std::string suffix = "-log.txt", Output* output = nullptr);
+    ~RollingFile();
+
+    RollingFile(const RollingFile&) = delete;
+    RollingFile& operator=(const RollingFile&) = delete;
+
+    // Appends `message` plus a newline, rolling first if the deadline passed.
+    void write(long long timestampNs, const std::string& message);
+    // Appends `message`, a space, the rendered payload and a newline. A large
+    // payload is not copied into the buffer: it goes out after the buffered
+    // bytes in one writev(), straight from the caller's memory when RAW.
+    // With sanitize_messages a RAW payload that needs it is escaped first.
+    void write(long long timestampNs, const std::string& message, const Payload& payload);
+
+    // Lower-level pieces of write() for appenders that frame their own output
+    bool rolloverDue(long long timestampNs) const {
+        return timestampNs >= nextRolloverNs_.load(std::memory_order_relaxed);
+    }
+    void roll(long long timestampNs);
+    // `countedBytes` is what max_file_size is charged for these bytes
+    void append(const char* data, std::size_t size, std::size_t countedBytes);
+
+    // With an Output, also waits until the bytes are in the file. Over
+    // memory_flush_percent of memory_budget the buffers are freed as well.
+    void flush();
+    // Signal-safe write of the buffer for crash handling; returns the fd
+    int emergencyFlush() noexcept;
+    // In a forked child: drop the inherited descriptor and buffer (the
+    // parent flushed it before forking) and open a file of our own on the
+    // next write, named per PID if fork_pid_suffix is set
+    void reopenAfterFork();
+
+    // Called by Config whenever a setting changes: every open file rolls on
+    // its next record, which reloads the cached settings
+    static void settingsChanged();
+    // Around fork(), for the list of open files
+    static void prepareFork();
+    static void afterFork();
+
+    const std::string& path() const { return path_; }
+    std::size_t size() const { return size_; }
+    unsigned generation() const { return generation_; }
+};
+
+#endif //ROLLINGFILE_H
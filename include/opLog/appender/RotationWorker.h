@@ -0,0 +1,65 @@
+#ifndef ROTATIONWORKER_H
+#define ROTATIONWORKER_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+
+// Background housekeeping for rotated log files.
+// The writer only renames the full file out of the way (one rename) and
+// submits it here; shifting the numbered backups and compressing them
+// (compress_rotated) happens on this low-priority thread.
+class RotationWorker {
+private:
+    struct Job {
+        std::string pendingPath; // empty: only compress existing backups
+        std::string basePath;
+    };
+
+    std::mutex mutex_;
+    std::condition_variable workCv_;
+    std::condition_variable idleCv_;
+    std::deque<Job> queue_;
+    std::set<std::string> queued_; // job keys not yet processed
+    std::set<std::string> recovered_; // directories already scanned
+    std::thread thread_;
+    bool busy_{false};
+    bool stop_{false};
+
+    RotationWorker() = default;
+
+    void run();
+    void submit(Job job);
+    void process(const Job& job);
+    void compressBackups(const std::string& basePath, int maxBackups);
+
+public:
+    ~RotationWorker();
+
+    RotationWorker(const RotationWorker&) = delete;
+    RotationWorker& operator=(const RotationWorker&) = delete;
+
+    static RotationWorker& getInstance();
+
+    // <dir>/<stem>.pending-<seq><ext>, e.g. 2024-01-15-log.pending-1705311025000000000.txt
+    static std::string pendingPath(const std::string& basePath, std::uint64_t seq);
+
+    void submit(const std::string& pendingPath, const std::string& basePath);
+
+    // Re-queue rotations left unfinished by a previous run in `directory`.
+    void recover(const std::string& directory);
+
+    // Block until every submitted rotation has been processed.
+    void drain();
+
+    // Held across fork(). Queued jobs stay with the parent; the child
+    // starts its own thread when it next rotates.
+    void prepareFork();
+    void afterFork(bool child);
+};
+
+#endif //ROTATIONWORKER_H
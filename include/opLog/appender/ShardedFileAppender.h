@@ -0,0 +1,54 @@
+#ifndef SHARDEDFILEAPPENDER_H
+#define SHARDEDFILEAPPENDER_H
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include "IAppender.h"
+#include "RollingFile.h"
+
+// FileAppender variant where every writing thread appends to its own shard,
+// e.g. 2024-01-15-log.t4242.txt, so writers share no file or buffer.
+// Each line is prefixed with the record timestamp in nanoseconds
+// ("1705311025000000000 [2024-01-15 10:30:25] [INFO] ...") so that
+// oplog-merge can rebuild one time-ordered stream from the shards.
+// Shards of threads that have exited are closed when a new shard is opened
+// and on flush(), so thread churn does not pile up descriptors and buffers.
+class ShardedFileAppender final : public IAppender {
+private:
+    struct Shard {
+        std::mutex mutex; // Only contended by flush()
+        RollingFile file;
+        std::string line;
+
+        explicit Shard(const std::string& suffix) : file(suffix) {}
+    };
+
+    std::uint64_t id_; // Never reused, keys the per-thread cache; renewed in a forked child
+    std::mutex shardsMutex_;
+    std::unordered_map<long, std::unique_ptr<Shard>> shards_;
+
+    Shard& currentShard();
+    // Closes the shards of exited threads; shardsMutex_ must be held
+    void closeExited();
+
+public:
+    // Width of the "<nanoseconds> " prefix on every shard line
+    static constexpr size_t kTimestampPrefix = 20;
+
+    ShardedFileAppender();
+    ~ShardedFileAppender() override = default;
+
+    void write(const std::string& message) override;
+    void write(const LogRecord& record, const std::string& message) override;
+    bool isThreadSafe() const override { return true; }
+    void flush() override;
+    // Flushes every shard; no marker, since oplog-merge expects prefixed lines
+    int emergencyFlush() noexcept override;
+    // A forked child drops the parent's shards; its threads have new ids
+    void prepareFork() override;
+    void afterFork(bool child) override;
+};
+
+#endif //SHARDEDFILEAPPENDER_H
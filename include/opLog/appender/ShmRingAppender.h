@@ -0,0 +1,29 @@
+#ifndef SHMRINGAPPENDER_H
+#define SHMRINGAPPENDER_H
+
+#include "IAppender.h"
+
+class ShmRing;
+
+// Hands records to oplog-collector through this process's shared-memory
+// ring (/dev/shm/<shm_ring_prefix>-<pid>) instead of writing files itself,
+// so many processes can share one log directory without racing on files or
+// rotation. The collector orders records by timestamp and owns the files.
+// Writes never block: when the ring is full the record is dropped and
+// counted in the ring header. A crash loses nothing: records are in shared
+// memory as soon as write() returns.
+class ShmRingAppender final : public IAppender {
+private:
+    ShmRing* ring_; // One per process, shared by all instances
+
+public:
+    ShmRingAppender();
+
+    void write(const std::string& message) override;
+    void write(const LogRecord& record, const std::string& message) override;
+    bool isThreadSafe() const override { return true; }
+    // A forked child gets a ring of its own, under its pid
+    void afterFork(bool child) override;
+};
+
+#endif //SHMRINGAPPENDER_H
@@ -0,0 +1,75 @@
+#ifndef TIMEINDEX_H
+#define TIMEINDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Sparse timestamp -> byte offset index kept next to a text log file
+// (2024-01-15-log.txt.idx). One entry is appended every `everyRecords`
+// records or `everyBytes` bytes, whichever comes first, so a reader can seek
+// close to a time range instead of scanning the whole file.
+//
+// File layout: 8-byte magic "OPLGIDX1" followed by fixed 16-byte entries
+// {int64 timestampNs, uint64 offset} in host byte order. The file is only
+// ever appended to; entries pointing past the end of the log (a crash before
+// buffered data reached the disk) are dropped and the tail is re-indexed
+// from the log text on open.
+class TimeIndex {
+public:
+    struct Entry {
+        long long timestampNs;
+        std::uint64_t offset;
+    };
+
+    static constexpr const char* kSuffix = ".idx";
+    static constexpr char kMagic[8] = {'O', 'P', 'L', 'G', 'I', 'D', 'X', '1'};
+
+private:
+    std::size_t everyRecords_;
+    std::size_t everyBytes_;
+    int fd_{-1};
+    std::size_t records_{0};
+    std::uint64_t lastOffset_{0};
+
+    void add(long long timestampNs, std::uint64_t offset);
+
+public:
+    TimeIndex(std::size_t everyRecords, std::size_t everyBytes);
+    ~TimeIndex();
+
+    TimeIndex(const TimeIndex&) = delete;
+    TimeIndex& operator=(const TimeIndex&) = delete;
+
+    // Opens the index of `logPath`, repairing or rebuilding it so it covers
+    // the log's current contents.
+    void open(const std::string& logPath);
+    void close();
+
+    // Called before each record is appended to the log at `offset`
+    void record(long long timestampNs, std::uint64_t offset) {
+        if (++records_ >= everyRecords_ || offset - lastOffset_ >= everyBytes_) {
+            add(timestampNs, offset);
+        }
+    }
+
+    // Valid entries of `indexPath` for a log currently `logSize` bytes long
+    static std::vector<Entry> load(const std::string& indexPath, std::uint64_t logSize);
+
+    // Index `data[from, size)` by parsing the timestamp text of each line
+    static void build(const char* data, std::size_t size, std::uint64_t from,
+                      const std::string& dateTimeFormat, std::size_t everyRecords, std::size_t everyBytes,
+                      std::vector<Entry>& entries);
+
+    // Write a complete index file (header plus `entries`)
+    static bool save(const std::string& indexPath, const std::vector<Entry>& entries);
+
+    // Line parsing shared with oplog-query. Both accept the with_brackets and
+    // no_brackets styles and ignore ANSI color codes.
+    static bool parseTimestamp(const char* line, std::size_t length, const std::string& dateTimeFormat,
+                               long long& timestampNs);
+    static int parseLevel(const char* line, std::size_t length); // LogLevel value, -1 if none
+};
+
+#endif //TIMEINDEX_H
@@ -0,0 +1,69 @@
+#ifndef UNIXSOCKETAPPENDER_H
+#define UNIXSOCKETAPPENDER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "IAppender.h"
+#include "opLog/MemoryBudget.h"
+
+// Sends records to a local log agent over a Unix socket (socket_path).
+// socket_type=dgram sends one datagram per record, many per sendmmsg call;
+// socket_type=stream sends newline-terminated records with one sendmsg per
+// batch. A sender thread owns the socket: producers only queue the record,
+// so a slow or missing agent never blocks them. While the agent is down the
+// sender reconnects with exponential backoff and records wait in memory up
+// to socket_buffer_bytes; past that new records are dropped and counted.
+class UnixSocketAppender final : public IAppender {
+private:
+    std::string path_;
+    bool stream_;
+    size_t bufferLimit_;
+
+    std::mutex mutex_;
+    std::condition_variable wake_;    // Sender: records queued or stopping
+    std::condition_variable drained_; // flush(): queue sent or agent down
+    std::deque<std::string> queue_;
+    size_t queuedBytes_{0};           // Includes the batch being sent
+    MemoryBudget::Account memory_;    // Follows queuedBytes_
+    size_t inFlight_{0};
+    bool agentDown_{false};
+    std::atomic<bool> stop_{false};
+    std::atomic<std::uint64_t> dropped_{0};
+    std::thread sender_;
+
+    // Sender thread only
+    int fd_{-1};
+    size_t streamOffset_{0}; // Bytes of the first queued record already sent
+
+    void run();
+    bool connect();
+    void disconnect();
+    size_t sendDatagrams(std::vector<std::string>& batch);
+    size_t sendStream(std::vector<std::string>& batch);
+
+public:
+    UnixSocketAppender();
+    ~UnixSocketAppender() override;
+
+    void write(const std::string& message) override;
+    void write(const LogRecord& record, const std::string& message) override;
+    bool isThreadSafe() const override { return true; }
+    // Waits until queued records are handed to the socket; returns early
+    // while the agent is unreachable
+    void flush() override;
+    // Best effort: pushes queued records if the agent is connected
+    int emergencyFlush() noexcept override;
+    // A forked child leaves the queue to the parent and connects on its own
+    void prepareFork() override;
+    void afterFork(bool child) override;
+
+    std::uint64_t droppedRecords() const { return dropped_.load(std::memory_order_relaxed); }
+};
+
+#endif //UNIXSOCKETAPPENDER_H
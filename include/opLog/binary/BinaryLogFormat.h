@@ -0,0 +1,77 @@
+#ifndef BINARYLOGFORMAT_H
+#define BINARYLOGFORMAT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// On-disk layout of binary log files (*-log.oplb).
+//
+// A file is a sequence of self-contained blocks. Each block starts with a
+// fixed BlockHeader whose summary (time range, level range) lets a reader
+// skip the block without decoding it, followed by `payloadSize` bytes of
+// columns:
+//
+//   timestamps  int64 first timestamp (ns), then recordCount-1 zigzag varint deltas
+//   levels      recordCount bytes (LogLevel values)
+//   dictionary  dictionaryCount x (varint length, bytes): distinct messages
+//   messages    recordCount varints indexing the dictionary
+//
+// A block cut short by a crash fails its length or checksum test and ends the
+// readable part of the file.
+namespace BinaryLogFormat {
+
+    constexpr std::uint32_t kBlockMagic = 0x424c504f; // "OPLB" little-endian
+    constexpr std::uint16_t kVersion = 1;
+
+    struct BlockHeader {
+        std::uint32_t magic;
+        std::uint16_t version;
+        std::uint8_t minLevel;
+        std::uint8_t maxLevel;
+        std::uint32_t recordCount;
+        std::uint32_t dictionaryCount;
+        std::int64_t minTimestampNs;
+        std::int64_t maxTimestampNs;
+        std::uint32_t payloadSize;
+        std::uint32_t checksum; // FNV-1a of the payload
+    };
+    static_assert(sizeof(BlockHeader) == 40, "BlockHeader must stay packed");
+
+    inline std::uint32_t checksum(const char* data, std::size_t size) {
+        std::uint32_t hash = 2166136261u;
+        for (std::size_t i = 0; i < size; ++i) {
+            hash = (hash ^ static_cast<unsigned char>(data[i])) * 16777619u;
+        }
+        return hash;
+    }
+
+    inline void putVarint(std::string& out, std::uint64_t value) {
+        while (value >= 0x80) {
+            out.push_back(static_cast<char>(value | 0x80));
+            value >>= 7;
+        }
+        out.push_back(static_cast<char>(value));
+    }
+
+    // Returns false on truncated or overlong input
+    inline bool getVarint(const char*& pos, const char* end, std::uint64_t& value) {
+        value = 0;
+        for (int shift = 0; shift < 64 && pos < end; shift += 7) {
+            const auto byte = static_cast<unsigned char>(*pos++);
+            value |= static_cast<std::uint64_t>(byte & 0x7f) << shift;
+            if ((byte & 0x80) == 0) return true;
+        }
+        return false;
+    }
+
+    inline std::uint64_t zigzag(std::int64_t value) {
+        return (static_cast<std::uint64_t>(value) << 1) ^ static_cast<std::uint64_t>(value >> 63);
+    }
+
+    inline std::int64_t unzigzag(std::uint64_t value) {
+        return static_cast<std::int64_t>(value >> 1) ^ -static_cast<std::int64_t>(value & 1);
+    }
+}
+
+#endif //BINARYLOGFORMAT_H
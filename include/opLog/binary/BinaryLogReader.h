@@ -0,0 +1,62 @@
+#ifndef BINARYLOGREADER_H
+#define BINARYLOGREADER_H
+
+#include <climits>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "opLog/LogLevel.h"
+
+// Reads files written by BinaryFileAppender. Opening a file only walks the
+// block headers; blocks are decoded on demand, and read() skips every block
+// whose time or level summary cannot match the filter.
+class BinaryLogReader {
+public:
+    struct BlockInfo {
+        std::uint64_t offset;      // Of the block header
+        std::uint32_t recordCount;
+        long long minTimestampNs;
+        long long maxTimestampNs;
+        LogLevel minLevel;
+        LogLevel maxLevel;
+    };
+
+    struct Filter {
+        long long fromNs{LLONG_MIN};
+        long long toNs{LLONG_MAX};
+        LogLevel minLevel{LogLevel::TRACE};
+    };
+
+    // The message view is only valid during the call
+    using Visitor = std::function<void(long long timestampNs, LogLevel level, std::string_view message)>;
+
+private:
+    const char* data_{nullptr};
+    std::size_t size_{0};
+    std::vector<BlockInfo> blocks_;
+    bool truncated_{false};
+
+public:
+    // Throws std::runtime_error if the file cannot be opened
+    explicit BinaryLogReader(const std::string& path);
+    ~BinaryLogReader();
+
+    BinaryLogReader(const BinaryLogReader&) = delete;
+    BinaryLogReader& operator=(const BinaryLogReader&) = delete;
+
+    const std::vector<BlockInfo>& blocks() const { return blocks_; }
+
+    // True if the file ends in an incomplete block (e.g. after a crash)
+    bool isTruncated() const { return truncated_; }
+
+    // Visits every record of block `index`; false if the block is corrupt
+    bool decodeBlock(std::size_t index, const Visitor& visitor) const;
+
+    // Visits the matching records in file order; returns the number of
+    // blocks that had to be decoded
+    std::size_t read(const Filter& filter, const Visitor& visitor) const;
+};
+
+#endif //BINARYLOGREADER_H
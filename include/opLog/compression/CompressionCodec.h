@@ -0,0 +1,10 @@
+#ifndef COMPRESSIONCODEC_H
+#define COMPRESSIONCODEC_H
+
+enum class CompressionCodec {
+    NONE,
+    GZIP, // zlib, .gz
+    ZSTD, // libzstd, .zst
+};
+
+#endif //COMPRESSIONCODEC_H
@@ -0,0 +1,40 @@
+#ifndef COMPRESSOR_H
+#define COMPRESSOR_H
+
+#include <string>
+#include "CompressionCodec.h"
+
+namespace Compressor {
+    // Whether support for `codec` was compiled in (NONE is always available)
+    bool isAvailable(CompressionCodec codec);
+
+    // File extension appended to compressed files: ".gz", ".zst" or ""
+    const char* extension(CompressionCodec codec);
+
+    // Compress `source` into `destination` in one stream and fsync the result.
+    // Throws std::runtime_error on failure; `destination` may then be partial.
+    void compressFile(const std::string& source, const std::string& destination, CompressionCodec codec);
+}
+
+// Compresses a stream as a sequence of independently decodable frames
+// (gzip members or zstd frames). Concatenated frames are a valid .gz/.zst
+// file, so output stays readable up to the last complete frame.
+class FrameEncoder {
+private:
+    CompressionCodec codec_;
+    void* state_{nullptr}; // z_stream or ZSTD_CCtx, reused across frames
+
+public:
+    explicit FrameEncoder(CompressionCodec codec);
+    ~FrameEncoder();
+
+    FrameEncoder(const FrameEncoder&) = delete;
+    FrameEncoder& operator=(const FrameEncoder&) = delete;
+
+    CompressionCodec codec() const { return codec_; }
+
+    // Appends one complete frame holding `size` bytes of `data` to `out`
+    void encode(const char* data, size_t size, std::string& out);
+};
+
+#endif //COMPRESSOR_H
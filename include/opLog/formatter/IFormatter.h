@@ -7,6 +7,12 @@
 class IFormatter {
 public:
     virtual ~IFormatter() = default;
+
+    // Called concurrently from every logging thread
     virtual std::string format(const LogRecord& record) = 0;
+
+    // format() without the min_log_level filter, for replaying records held
+    // in the backtrace ring
+    virtual std::string formatUnfiltered(const LogRecord& record) { return format(record); }
 };
 #endif //FORMATTER_H
@@ -0,0 +1,26 @@
+#ifndef MESSAGESANITIZER_H
+#define MESSAGESANITIZER_H
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+// Escapes the bytes in a message that could break a log line or reach a
+// terminal as a command (sanitize_messages): C0 controls and DEL. \n, \r
+// and \t are written as such and the rest as \xHH; everything else,
+// including UTF-8 sequences and backslashes, is copied unchanged.
+//
+// The scan tests 32 bytes per step with AVX2 where the CPU has it and 16
+// with SSE2 otherwise, and the runs between escapes are appended whole, so
+// a clean message costs about as much as reading it.
+class MessageSanitizer {
+public:
+    // Offset of the first byte to escape, or size if there is none
+    static std::size_t findUnsafe(const char* data, std::size_t size);
+    static bool isClean(std::string_view text) { return findUnsafe(text.data(), text.size()) == text.size(); }
+
+    static void appendEscaped(std::string& out, std::string_view text);
+    static std::string escape(std::string_view text);
+};
+
+#endif //MESSAGESANITIZER_H
@@ -1,19 +1,23 @@
 #ifndef PLAINTEXTFORMATTER_H
 #define PLAINTEXTFORMATTER_H
 
+#include <optional>
 #include "FormatStyle.h"
 #include "IFormatter.h"
 
+namespace opLog { class Config; }
+
 class PlainTextFormatter final : public IFormatter {
 
 private:
-    static std::string logLevelToString(const LogLevel& logLevel);
-    FormatStyle style{FormatStyle::STYLE_WITH_BRACKETS};
+    static std::string logLevelToString(const opLog::Config& config, const LogLevel& logLevel);
+    std::optional<FormatStyle> style; // Unset: format_style, as it is when the record is written
 public:
     PlainTextFormatter() = default;
     explicit PlainTextFormatter(FormatStyle style);
 
     std::string format(const LogRecord& record) override;
+    std::string formatUnfiltered(const LogRecord& record) override;
 };
 
 #endif //PLAINTEXTFORMATTER_H
@@ -0,0 +1,103 @@
+#ifndef SHMRING_H
+#define SHMRING_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <sys/types.h>
+#include "opLog/LogLevel.h"
+
+// Lock-free multi-producer / single-consumer record ring in POSIX shared
+// memory (shm_open + mmap), shared between a logging process and
+// oplog-collector.
+//
+// The ring is an array of fixed-size slots, each carrying a sequence number.
+// Producers reserve consecutive tickets with a CAS on `head`, copy the record
+// in, then publish every slot by storing ticket + 1 into its sequence. The
+// collector only reads a record once all of its slots are published and
+// frees them by advancing their sequence by one lap. A producer that dies
+// mid-write therefore leaves unpublished slots that are never read; the
+// collector notices the owner is gone and retires the ring.
+class ShmRing {
+public:
+    static constexpr std::uint64_t kMagic = 0x31474e49524c504fULL; // "OPLRING1"
+    static constexpr std::size_t kSlotSize = 256;
+
+    struct Record {
+        long long timestampNs;
+        LogLevel level;
+        std::string message;
+    };
+
+    enum class ReadResult {
+        RECORD,  // `out` holds the next record
+        EMPTY,   // Nothing published
+        PENDING, // Next record reserved but not yet (or never) published
+    };
+
+private:
+    struct Header {
+        std::atomic<std::uint64_t> magic; // Stored last by the creator
+        std::uint64_t slotCount;          // Power of two
+        pid_t pid;
+        alignas(64) std::atomic<std::uint64_t> head; // Next ticket to reserve
+        alignas(64) std::atomic<std::uint64_t> tail; // Next ticket to consume
+        alignas(64) std::atomic<std::uint64_t> dropped;
+    };
+
+    struct Slot {
+        std::atomic<std::uint64_t> sequence;
+        char payload[kSlotSize - sizeof(std::atomic<std::uint64_t>)];
+    };
+
+    // Start of a record's first slot payload
+    struct RecordHeader {
+        std::int64_t timestampNs;
+        std::uint32_t length;
+        std::uint16_t slots;
+        std::uint8_t level;
+        std::uint8_t reserved;
+    };
+
+    static_assert(std::atomic<std::uint64_t>::is_always_lock_free, "shared memory needs address-free atomics");
+    static_assert(sizeof(Slot) == kSlotSize, "Slot must fill kSlotSize");
+
+    std::string name_;
+    void* mapping_{nullptr};
+    std::size_t mappingSize_{0};
+    Header* header_{nullptr};
+    Slot* slots_{nullptr};
+    std::uint64_t mask_{0};
+
+    ShmRing() = default;
+    static std::size_t sizeFor(std::uint64_t slotCount);
+
+public:
+    ~ShmRing();
+
+    ShmRing(const ShmRing&) = delete;
+    ShmRing& operator=(const ShmRing&) = delete;
+
+    // Producer side: create (replacing any stale ring of the same name).
+    // Throws std::runtime_error on failure.
+    static ShmRing* create(const std::string& name, std::uint64_t slotCount);
+    // Collector side: map an existing ring; nullptr if it is not ready
+    static ShmRing* attach(const std::string& name);
+
+    const std::string& name() const { return name_; }
+    pid_t ownerPid() const { return header_->pid; }
+    std::uint64_t dropped() const { return header_->dropped.load(std::memory_order_relaxed); }
+
+    // Never blocks: returns false (and counts a drop) when the ring is full.
+    // Messages longer than a quarter of the ring are truncated.
+    bool tryWrite(long long timestampNs, LogLevel level, const char* message, std::size_t length);
+
+    // Single consumer only
+    ReadResult tryRead(Record& out);
+
+    // Removes the name; the mapping stays valid until destruction
+    void unlink();
+};
+
+#endif //SHMRING_H
@@ -0,0 +1,28 @@
+#include "opLog/BacktraceRing.h"
+
+BacktraceRing::BacktraceRing(std::size_t capacity)
+    : entries_(capacity == 0 ? 1 : capacity), spare_(entries_.size()) {
+    for (auto* entries : {&entries_, &spare_}) {
+        for (Entry& entry : *entries) {
+            entry.message.reserve(kMessageReserve);
+        }
+    }
+    memory_.set(2 * entries_.size() * (sizeof(Entry) + entries_.front().message.capacity()));
+}
+
+void BacktraceRing::push(LogLevel level, const std::string& message,
+                         std::chrono::system_clock::time_point timestamp) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Entry& entry = entries_[next_];
+    entry.timestamp = timestamp;
+    entry.level = level;
+    const std::size_t reserved = entry.message.capacity();
+    entry.message.assign(message); // Reuses the slot's capacity
+    if (entry.message.capacity() != reserved) {
+        memory_.set(memory_.bytes() + entry.message.capacity() - reserved);
+    }
+    next_ = (next_ + 1) % entries_.size();
+    if (count_ < entries_.size()) {
+        ++count_;
+    }
+}
@@ -3,18 +3,32 @@
 #include <sstream>
 #include <algorithm>
 #include <filesystem>
+#include <memory>
 #include "opLog/Config.h"
+#include "opLog/ConfigWatcher.h"
+#include "opLog/TimeSource.h"
+#include "opLog/appender/RollingFile.h"
+#include "opLog/compression/Compressor.h"
 
 
 namespace opLog {
-    Config* Config::instance = nullptr;
+    std::atomic<Config*> Config::instance{nullptr};
+    std::vector<Config*> Config::retired;
+    std::atomic<unsigned> Config::generation_{0};
+    std::mutex Config::mutex_;
 
     Config &Config::getInstance() {
-        if (instance == nullptr) {
-            instance = new Config();
-            instance->setDefaultConfig();
+        Config* config = instance.load(std::memory_order_acquire);
+        if (config == nullptr) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            config = instance.load(std::memory_order_relaxed);
+            if (config == nullptr) {
+                config = new Config();
+                config->setDefaultConfig();
+                instance.store(config, std::memory_order_release);
+            }
         }
-        return *instance;
+        return *config;
     }
 
     void Config::setDefaultConfig() {
@@ -39,7 +53,49 @@ std::vector<std::string> Config::split(const std::string& str, char delimiter) {
     return tokens;
 }
 
-void Config::parseConfigFile(const std::string& filepath) {
+CompressionCodec Config::parseCodec(const std::string& value, CompressionCodec current) {
+    CompressionCodec codec = current;
+    if (value == "none") codec = CompressionCodec::NONE;
+    else if (value == "gzip") codec = CompressionCodec::GZIP;
+    else if (value == "zstd") codec = CompressionCodec::ZSTD;
+    else std::cerr << "Warning: Unknown compression codec: " << value << std::endl;
+
+    // Prefer zstd, fall back to gzip, then to no compression
+    if (codec == CompressionCodec::ZSTD && !Compressor::isAvailable(codec)) {
+        std::cerr << "Warning: zstd support not built in, falling back to gzip" << std::endl;
+        codec = CompressionCodec::GZIP;
+    }
+    if (codec == CompressionCodec::GZIP && !Compressor::isAvailable(codec)) {
+        std::cerr << "Warning: gzip support not built in, output stays uncompressed" << std::endl;
+        codec = CompressionCodec::NONE;
+    }
+    return codec;
+}
+
+LogLevel Config::parseLevel(const std::string& value, LogLevel current) {
+    if (value == "TRACE") return LogLevel::TRACE;
+    if (value == "DEBUG") return LogLevel::DEBUG;
+    if (value == "INFO") return LogLevel::INFO;
+    if (value == "WARN") return LogLevel::WARN;
+    if (value == "ERROR") return LogLevel::ERROR;
+    if (value == "FATAL") return LogLevel::FATAL;
+    std::cerr << "Warning: Unknown log level: " << value << std::endl;
+    return current;
+}
+
+const char* Config::levelToString(LogLevel level) {
+    switch (level) {
+        case LogLevel::TRACE: return "TRACE";
+        case LogLevel::DEBUG: return "DEBUG";
+        case LogLevel::INFO: return "INFO";
+        case LogLevel::WARN: return "WARN";
+        case LogLevel::ERROR: return "ERROR";
+        case LogLevel::FATAL: return "FATAL";
+    }
+    return "UNKNOWN";
+}
+
+int Config::parseConfigFile(const std::string& filepath) {
     std::ifstream file(filepath);
     if (!file.is_open()) {
         throw std::runtime_error("Cannot open config file: " + filepath);
@@ -47,6 +103,7 @@ void Config::parseConfigFile(const std::string& filepath) {
 
     std::string line;
     int lineNumber = 0;
+    int failed = 0;
 
     while (std::getline(file, line)) {
         lineNumber++;
@@ -97,12 +154,118 @@ void Config::parseConfigFile(const std::string& filepath) {
                 maxFileSize = std::stoull(value);
             } else if (key == "max_backup_files") {
                 maxBackupFiles = std::stoi(value);
+            } else if (key == "rotation_interval") {
+                if (value == "daily") rotationInterval = 86400;
+                else if (value == "hourly") rotationInterval = 3600;
+                else if (value == "none") rotationInterval = 0;
+                else if (std::stoll(value) >= 0) rotationInterval = std::stoll(value);
+                else std::cerr << "Warning: Invalid rotation interval: " << value << std::endl;
+            } else if (key == "compress_rotated") {
+                compressRotated = parseCodec(value, compressRotated);
+            } else if (key == "file_sharding") {
+                fileSharding = (value == "true" || value == "1" || value == "yes");
+            } else if (key == "io_uring") {
+                ioUring = (value == "true" || value == "1" || value == "yes");
+            } else if (key == "io_uring_buffers") {
+                ioUringBuffers = std::stoull(value);
+            } else if (key == "payload_max_bytes") {
+                payloadMaxBytes = std::stoull(value);
+            } else if (key == "file_format") {
+                if (value == "text") binaryFormat = false;
+                else if (value == "binary") binaryFormat = true;
+                else std::cerr << "Warning: Unknown file format: " << value << std::endl;
+            } else if (key == "binary_block_records") {
+                binaryBlockRecords = std::stoull(value);
+            } else if (key == "binary_block_bytes") {
+                binaryBlockBytes = std::stoull(value);
+            } else if (key == "binary_block_interval_ms") {
+                binaryBlockIntervalMs = std::stoll(value);
+            } else if (key == "shm_ring") {
+                shmRing = (value == "true" || value == "1" || value == "yes");
+            } else if (key == "shm_ring_prefix") {
+                shmRingPrefix = value;
+            } else if (key == "shm_ring_slots") {
+                shmRingSlots = std::stoull(value);
+            } else if (key == "time_index") {
+                timeIndex = (value == "true" || value == "1" || value == "yes");
+            } else if (key == "time_index_records") {
+                timeIndexRecords = std::stoull(value);
+            } else if (key == "time_index_bytes") {
+                timeIndexBytes = std::stoull(value);
+            } else if (key == "stream_compression") {
+                streamCompression = parseCodec(value, streamCompression);
+            } else if (key == "compression_frame_size") {
+                compressionFrameSize = std::stoull(value);
+            } else if (key == "compression_frame_interval_ms") {
+                compressionFrameIntervalMs = std::stoll(value);
+            } else if (key == "max_file_size_compressed") {
+                maxFileSizeCompressed = (value == "true" || value == "1" || value == "yes");
+            } else if (key == "clock_source") {
+                if (value == "precise") clockSource = ClockSource::PRECISE;
+                else if (value == "coarse") clockSource = ClockSource::COARSE;
+                else if (value == "tsc") clockSource = ClockSource::TSC;
+                else std::cerr << "Warning: Unknown clock source: " << value << std::endl;
+            } else if (key == "tsc_calibration_ms") {
+                tscCalibrationMs = std::stoll(value);
+            } else if (key == "async_logging") {
+                asyncLogging = (value == "true" || value == "1" || value == "yes");
+            } else if (key == "async_workers") {
+                asyncWorkers = std::stoull(value);
+            } else if (key == "async_queue_records") {
+                asyncQueueRecords = std::stoull(value);
+            } else if (key == "async_quantum") {
+                asyncQuantum = std::stoull(value);
+            } else if (key == "async_idle_ms") {
+                asyncIdleMs = std::stoll(value);
+            } else if (key == "backtrace_size") {
+                backtraceSize = std::stoull(value);
+            } else if (key == "backtrace_trigger_level") {
+                backtraceTriggerLevel = parseLevel(value, backtraceTriggerLevel);
+            } else if (key == "crash_handler") {
+                crashHandler = (value == "true" || value == "1" || value == "yes");
+            } else if (key == "crash_backtrace") {
+                crashBacktrace = (value == "true" || value == "1" || value == "yes");
+            } else if (key == "fork_safe") {
+                forkSafe = (value == "true" || value == "1" || value == "yes");
+            } else if (key == "fork_pid_suffix") {
+                forkPidSuffix = (value == "true" || value == "1" || value == "yes");
+            } else if (key == "watch_config") {
+                watchConfig = (value == "true" || value == "1" || value == "yes");
+            } else if (key == "watch_debounce_ms") {
+                watchDebounceMs = std::stoll(value);
+            } else if (key == "memory_budget") {
+                memoryBudget = std::stoull(value);
+            } else if (key == "memory_flush_percent") {
+                memoryFlushPercent = std::stoull(value);
+            } else if (key == "memory_shed_level") {
+                memoryShedLevel = parseLevel(value, memoryShedLevel);
+            } else if (key == "socket_path") {
+                socketPath = value;
+            } else if (key == "socket_type") {
+                if (value == "dgram" || value == "datagram") socketStream = false;
+                else if (value == "stream") socketStream = true;
+                else std::cerr << "Warning: Unknown socket type: " << value << std::endl;
+            } else if (key == "socket_buffer_bytes") {
+                socketBufferBytes = std::stoull(value);
+            } else if (key == "console_colors") {
+                if (value == "auto") consoleColors = ConsoleColors::AUTO;
+                else if (value == "always") consoleColors = ConsoleColors::ALWAYS;
+                else if (value == "never") consoleColors = ConsoleColors::NEVER;
+                else std::cerr << "Warning: Unknown console color mode: " << value << std::endl;
+            } else if (key == "console_split_stderr") {
+                consoleSplitStderr = (value == "true" || value == "1" || value == "yes");
+            } else if (key == "console_stderr_level") {
+                consoleStderrLevel = parseLevel(value, consoleStderrLevel);
+            } else if (key == "console_flush_interval_ms") {
+                consoleFlushIntervalMs = std::stoll(value);
             } else if (key == "enable_colors") {
                 enableColors = (value == "true" || value == "1" || value == "yes");
             } else if (key == "enable_timestamp") {
                 enableTimestamp = (value == "true" || value == "1" || value == "yes");
             } else if (key == "datetime_format") {
                 dateTimeFormat = value;
+            } else if (key == "sanitize_messages") {
+                sanitizeMessages = (value == "true" || value == "1" || value == "yes");
             } else if (key == "auto_flush") {
                 autoFlush = (value == "true" || value == "1" || value == "yes");
             } else if (key == "trace_color") {
@@ -122,18 +285,85 @@ void Config::parseConfigFile(const std::string& filepath) {
             }
         } catch (const std::exception& e) {
             std::cerr << "Error parsing line " << lineNumber << ": " << e.what() << std::endl;
+            ++failed;
         }
     }
 
     file.close();
+    return failed;
+}
+
+std::vector<std::string> Config::validate() const {
+    std::vector<std::string> problems;
+    if (logDirectory.empty()) problems.emplace_back("log_directory is empty");
+    if (maxFileSize == 0) problems.emplace_back("max_file_size is 0");
+    if (rotationInterval < 0) problems.emplace_back("rotation_interval is negative");
+    if (dateTimeFormat.empty()) problems.emplace_back("datetime_format is empty");
+    if (ioUringBuffers == 0) problems.emplace_back("io_uring_buffers is 0");
+    if (compressionFrameSize == 0) problems.emplace_back("compression_frame_size is 0");
+    if (asyncQueueRecords == 0) problems.emplace_back("async_queue_records is 0");
+    if (asyncQuantum == 0) problems.emplace_back("async_quantum is 0");
+    if (memoryFlushPercent == 0 || memoryFlushPercent > 100) {
+        problems.emplace_back("memory_flush_percent is not between 1 and 100");
+    }
+    if (watchDebounceMs < 0) problems.emplace_back("watch_debounce_ms is negative");
+    return problems;
 }
 
-void Config::reloadConfig() {
-    if (!configFilePath.empty()) {
-        parseConfigFile(configFilePath);
+void Config::changed() {
+    generation_.fetch_add(1, std::memory_order_release);
+    RollingFile::settingsChanged();
+
+    // The clock is process-wide: switch it only when its settings change,
+    // so neither other setters nor new loggers undo a direct select()
+    static ClockSource appliedClock = ClockSource::PRECISE;
+    static long long appliedCalibrationMs = 0;
+    const Config& config = *instance.load(std::memory_order_relaxed);
+    if (config.clockSource != appliedClock ||
+        (config.clockSource == ClockSource::TSC && config.tscCalibrationMs != appliedCalibrationMs)) {
+        appliedClock = config.clockSource;
+        appliedCalibrationMs = config.tscCalibrationMs;
+        TimeSource::select(appliedClock, appliedCalibrationMs);
     }
 }
 
+bool Config::publishFromFile(const Config& base, const std::string& path) {
+    // Settings made in code and keys left out of the file carry over
+    std::unique_ptr<Config> fresh(new Config(base));
+    fresh->configFilePath = path;
+    std::vector<std::string> problems;
+    try {
+        if (const int failed = fresh->parseConfigFile(path)) {
+            problems.push_back(std::to_string(failed) + " line(s) could not be parsed");
+        }
+    } catch (const std::exception& e) {
+        problems.emplace_back(e.what());
+    }
+    const std::vector<std::string> invalid = fresh->validate();
+    problems.insert(problems.end(), invalid.begin(), invalid.end());
+    if (!problems.empty()) {
+        std::cerr << "Config from " << path << " rejected, keeping current settings:";
+        for (const auto& problem : problems) {
+            std::cerr << "\n  " << problem;
+        }
+        std::cerr << std::endl;
+        return false;
+    }
+
+    retired.push_back(instance.exchange(fresh.release(), std::memory_order_acq_rel));
+    changed();
+    return true;
+}
+
+bool Config::reloadConfig() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const Config& current = *instance.load(std::memory_order_relaxed); // Not *this, which may be retired
+    if (current.configFilePath.empty()) {
+        return false;
+    }
+    return publishFromFile(current, current.configFilePath);
+}
+
 void Config::saveConfig(const std::string& filepath) {
     std::string outputPath = filepath.empty() ? configFilePath : filepath;
     if (outputPath.empty()) {
@@ -168,12 +398,117 @@ void Config::saveConfig(const std::string& filepath) {
 
     file << "# File rotation settings\n";
     file << "max_file_size=" << maxFileSize << "\n";
-    file << "max_backup_files=" << maxBackupFiles << "\n\n";
+    file << "max_backup_files=" << maxBackupFiles << "\n";
+    file << "rotation_interval=";
+    if (rotationInterval == 86400) file << "daily";
+    else if (rotationInterval == 3600) file << "hourly";
+    else if (rotationInterval == 0) file << "none";
+    else file << rotationInterval;
+    file << "\n";
+    file << "compress_rotated=";
+    switch (compressRotated) {
+        case CompressionCodec::NONE: file << "none"; break;
+        case CompressionCodec::GZIP: file << "gzip"; break;
+        case CompressionCodec::ZSTD: file << "zstd"; break;
+    }
+    file << "\n";
+    file << "file_sharding=" << (fileSharding ? "true" : "false") << "\n\n";
+
+    file << "# Submit file writes through io_uring (falls back to pwrite)\n";
+    file << "io_uring=" << (ioUring ? "true" : "false") << "\n";
+    file << "io_uring_buffers=" << ioUringBuffers << "\n\n";
+
+    file << "# Payload bytes written per record (0 = all of them)\n";
+    file << "payload_max_bytes=" << payloadMaxBytes << "\n\n";
+
+    file << "# On-disk format: text or binary (see oplog-dump)\n";
+    file << "file_format=" << (binaryFormat ? "binary" : "text") << "\n";
+    file << "binary_block_records=" << binaryBlockRecords << "\n";
+    file << "binary_block_bytes=" << binaryBlockBytes << "\n";
+    file << "binary_block_interval_ms=" << binaryBlockIntervalMs << "\n\n";
+
+    file << "# Cross-process shared-memory ring drained by oplog-collector\n";
+    file << "shm_ring=" << (shmRing ? "true" : "false") << "\n";
+    file << "shm_ring_prefix=" << shmRingPrefix << "\n";
+    file << "shm_ring_slots=" << shmRingSlots << "\n\n";
+
+    file << "# Sparse time index sidecar (.idx) for oplog-query\n";
+    file << "time_index=" << (timeIndex ? "true" : "false") << "\n";
+    file << "time_index_records=" << timeIndexRecords << "\n";
+    file << "time_index_bytes=" << timeIndexBytes << "\n\n";
+
+    file << "# Streaming compression (CompressedFileAppender)\n";
+    file << "stream_compression=";
+    switch (streamCompression) {
+        case CompressionCodec::NONE: file << "none"; break;
+        case CompressionCodec::GZIP: file << "gzip"; break;
+        case CompressionCodec::ZSTD: file << "zstd"; break;
+    }
+    file << "\n";
+    file << "compression_frame_size=" << compressionFrameSize << "\n";
+    file << "compression_frame_interval_ms=" << compressionFrameIntervalMs << "\n";
+    file << "max_file_size_compressed=" << (maxFileSizeCompressed ? "true" : "false") << "\n\n";
+
+    file << "# Where record timestamps come from\n";
+    file << "clock_source=";
+    switch (clockSource) {
+        case ClockSource::PRECISE: file << "precise"; break;
+        case ClockSource::COARSE: file << "coarse"; break;
+        case ClockSource::TSC: file << "tsc"; break;
+    }
+    file << "\n";
+    file << "tsc_calibration_ms=" << tscCalibrationMs << "\n\n";
+
+    file << "# Asynchronous logging through a shared worker pool\n";
+    file << "async_logging=" << (asyncLogging ? "true" : "false") << "\n";
+    file << "async_workers=" << asyncWorkers << "\n";
+    file << "async_queue_records=" << asyncQueueRecords << "\n";
+    file << "async_quantum=" << asyncQuantum << "\n";
+    file << "async_idle_ms=" << asyncIdleMs << "\n\n";
+
+    file << "# Recent records below min_log_level, written out on a trigger record\n";
+    file << "backtrace_size=" << backtraceSize << "\n";
+    file << "backtrace_trigger_level=" << levelToString(backtraceTriggerLevel) << "\n\n";
+
+    file << "# Flush buffered records on fatal signals and std::terminate\n";
+    file << "crash_handler=" << (crashHandler ? "true" : "false") << "\n";
+    file << "crash_backtrace=" << (crashBacktrace ? "true" : "false") << "\n\n";
+
+    file << "# Quiesce around fork(); children can log to per-PID files\n";
+    file << "fork_safe=" << (forkSafe ? "true" : "false") << "\n";
+    file << "fork_pid_suffix=" << (forkPidSuffix ? "true" : "false") << "\n\n";
+
+    file << "# Reload this file when it changes\n";
+    file << "watch_config=" << (watchConfig ? "true" : "false") << "\n";
+    file << "watch_debounce_ms=" << watchDebounceMs << "\n\n";
+
+    file << "# Memory opLog may hold for records and buffers (0 = unlimited)\n";
+    file << "memory_budget=" << memoryBudget << "\n";
+    file << "memory_flush_percent=" << memoryFlushPercent << "\n";
+    file << "memory_shed_level=" << levelToString(memoryShedLevel) << "\n\n";
+
+    file << "# Local log agent (UnixSocketAppender)\n";
+    file << "socket_path=" << socketPath << "\n";
+    file << "socket_type=" << (socketStream ? "stream" : "dgram") << "\n";
+    file << "socket_buffer_bytes=" << socketBufferBytes << "\n\n";
+
+    file << "# Console output\n";
+    file << "console_colors=";
+    switch (consoleColors) {
+        case ConsoleColors::AUTO: file << "auto"; break;
+        case ConsoleColors::ALWAYS: file << "always"; break;
+        case ConsoleColors::NEVER: file << "never"; break;
+    }
+    file << "\n";
+    file << "console_split_stderr=" << (consoleSplitStderr ? "true" : "false") << "\n";
+    file << "console_stderr_level=" << levelToString(consoleStderrLevel) << "\n";
+    file << "console_flush_interval_ms=" << consoleFlushIntervalMs << "\n\n";
 
     file << "# Display settings\n";
     file << "enable_colors=" << (enableColors ? "true" : "false") << "\n";
     file << "enable_timestamp=" << (enableTimestamp ? "true" : "false") << "\n";
     file << "datetime_format=" << dateTimeFormat << "\n";
+    file << "sanitize_messages=" << (sanitizeMessages ? "true" : "false") << "\n";
     file << "auto_flush=" << (autoFlush ? "true" : "false") << "\n\n";
 
     file << "# Log level colors (ANSI escape sequences)\n";
@@ -204,6 +539,14 @@ void Config::printCurrentConfig() const {
     std::cout << std::endl;
     std::cout << "Max File Size: " << maxFileSize << " bytes" << std::endl;
     std::cout << "Max Backup Files: " << maxBackupFiles << std::endl;
+    std::cout << "Rotation Interval: " << rotationInterval << " seconds" << std::endl;
+    std::cout << "Compress Rotated: ";
+    switch (compressRotated) {
+        case CompressionCodec::NONE: std::cout << "none"; break;
+        case CompressionCodec::GZIP: std::cout << "gzip"; break;
+        case CompressionCodec::ZSTD: std::cout << "zstd"; break;
+    }
+    std::cout << std::endl;
     std::cout << "Colors Enabled: " << (enableColors ? "Yes" : "No") << std::endl;
     std::cout << "Timestamp Enabled: " << (enableTimestamp ? "Yes" : "No") << std::endl;
     std::cout << "DateTime Format: " << dateTimeFormat << std::endl;
@@ -213,7 +556,7 @@ void Config::printCurrentConfig() const {
 
 
     void Config::initialize(const std::string &configPath) {
-        Config& config = Config::getInstance();
+        Config::getInstance(); // Creates the defaults the file is applied to
 
         std::string actualConfigPath = configPath;
         if (actualConfigPath.empty()) {
@@ -233,9 +576,29 @@ void Config::printCurrentConfig() const {
         }
 
         if (!actualConfigPath.empty() && std::filesystem::exists(actualConfigPath)) {
-            config.configFilePath = actualConfigPath;
-            config.parseConfigFile(actualConfigPath);
+            bool watch;
+            long long debounceMs;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                Config& config = *instance.load(std::memory_order_relaxed);
+                if (config.configFilePath == actualConfigPath) {
+                    return;
+                }
+                // Keys that parse are applied and parseConfigFile() warns about
+                // the rest; only a live reload rejects a whole file
+                config.configFilePath = actualConfigPath;
+                config.parseConfigFile(actualConfigPath);
+                for (const auto& problem : config.validate()) {
+                    std::cerr << "Warning: " << problem << std::endl;
+                }
+                watch = config.watchConfig;
+                debounceMs = config.watchDebounceMs;
+                changed();
+            }
             std::cout << "Loaded config from: " << actualConfigPath << std::endl;
+            if (watch) {
+                ConfigWatcher::getInstance().start(actualConfigPath, debounceMs);
+            }
         } else {
             std::cout << "No config file found, using defaults" << std::endl;
         }
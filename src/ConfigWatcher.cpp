@@ -0,0 +1,143 @@
+#include "opLog/ConfigWatcher.h"
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#include "opLog/Config.h"
+#include "opLog/ForkHandler.h"
+
+ConfigWatcher& ConfigWatcher::getInstance() {
+    static ConfigWatcher watcher;
+    return watcher;
+}
+
+ConfigWatcher::~ConfigWatcher() {
+    stop();
+}
+
+bool ConfigWatcher::start(const std::string& path, long long debounceMs) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (thread_.joinable() && path == path_) {
+        return true;
+    }
+    stopLocked();
+    return startLocked(path, debounceMs);
+}
+
+bool ConfigWatcher::startLocked(const std::string& path, long long debounceMs) {
+    std::filesystem::path directory = std::filesystem::path(path).parent_path();
+    if (directory.empty()) {
+        directory = ".";
+    }
+
+    const int inotifyFd = ::inotify_init1(IN_CLOEXEC | IN_NONBLOCK);
+    if (inotifyFd < 0) {
+        std::cerr << "ConfigWatcher: inotify unavailable (" << std::strerror(errno) << ")" << std::endl;
+        return false;
+    }
+    // The directory, not the file: a rename over the file replaces its inode
+    if (::inotify_add_watch(inotifyFd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+        std::cerr << "ConfigWatcher: cannot watch " << directory << " (" << std::strerror(errno) << ")" << std::endl;
+        ::close(inotifyFd);
+        return false;
+    }
+    const int wakeFd = ::eventfd(0, EFD_CLOEXEC);
+    if (wakeFd < 0) {
+        ::close(inotifyFd);
+        return false;
+    }
+
+    path_ = path;
+    debounceMs_ = debounceMs;
+    inotifyFd_ = inotifyFd;
+    wakeFd_ = wakeFd;
+    thread_ = std::thread(&ConfigWatcher::run, this, inotifyFd, wakeFd, path, debounceMs);
+    return true;
+}
+
+void ConfigWatcher::stop() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopLocked();
+}
+
+void ConfigWatcher::stopLocked() {
+    if (!thread_.joinable()) {
+        return;
+    }
+    const std::uint64_t one = 1;
+    (void)::write(wakeFd_, &one, sizeof(one));
+    thread_.join();
+    ::close(inotifyFd_);
+    ::close(wakeFd_);
+    inotifyFd_ = wakeFd_ = -1;
+    path_.clear();
+}
+
+bool ConfigWatcher::isRunning() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return thread_.joinable();
+}
+
+void ConfigWatcher::prepareFork() {
+    mutex_.lock();
+}
+
+void ConfigWatcher::afterFork(bool child) {
+    if (!child || !thread_.joinable()) {
+        mutex_.unlock();
+        return;
+    }
+    // The thread did not come along; the descriptors did
+    ForkHandler::reinitialize(thread_);
+    ::close(inotifyFd_);
+    ::close(wakeFd_);
+    inotifyFd_ = wakeFd_ = -1;
+    const std::string path = path_;
+    startLocked(path, debounceMs_);
+    mutex_.unlock();
+}
+
+void ConfigWatcher::run(int inotifyFd, int wakeFd, std::string path, long long debounceMs) {
+    const std::string name = std::filesystem::path(path).filename().string();
+    alignas(inotify_event) char buffer[4096];
+    bool changed = false;
+
+    while (true) {
+        pollfd fds[2] = {{inotifyFd, POLLIN, 0}, {wakeFd, POLLIN, 0}};
+        // Wait for the first event, then for a quiet debounce period
+        const int ready = ::poll(fds, 2, changed ? static_cast<int>(debounceMs) : -1);
+        if (ready < 0) {
+            if (errno == EINTR) continue;
+            std::cerr << "ConfigWatcher: " << std::strerror(errno) << std::endl;
+            return;
+        }
+        if (fds[1].revents != 0) {
+            return;
+        }
+
+        if (ready == 0) {
+            changed = false;
+            if (opLog::Config::getInstance().reloadConfig()) {
+                applied_.fetch_add(1, std::memory_order_relaxed);
+            } else {
+                rejected_.fetch_add(1, std::memory_order_relaxed);
+            }
+            continue;
+        }
+
+        ssize_t length;
+        while ((length = ::read(inotifyFd, buffer, sizeof(buffer))) > 0) {
+            for (char* at = buffer; at < buffer + length;) {
+                const auto* event = reinterpret_cast<const inotify_event*>(at);
+                if ((event->mask & IN_Q_OVERFLOW) != 0 || (event->len > 0 && name == event->name)) {
+                    changed = true;
+                }
+                at += sizeof(inotify_event) + event->len;
+            }
+        }
+    }
+}
@@ -0,0 +1,155 @@
+#include "opLog/CrashHandler.h"
+#include <atomic>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <exception>
+#include <mutex>
+#include <execinfo.h>
+#include <unistd.h>
+#include "opLog/appender/IAppender.h"
+
+namespace {
+    constexpr int FATAL_SIGNALS[] = {SIGSEGV, SIGABRT, SIGBUS, SIGFPE};
+    constexpr int MAX_FRAMES = 64;
+
+    std::atomic<IAppender*> registry[CrashHandler::kMaxAppenders];
+    std::atomic<bool> backtraceEnabled{false};
+    std::atomic<bool> handled{false};
+    std::once_flag installed;
+
+    struct sigaction previousActions[NSIG];
+    std::terminate_handler previousTerminate = nullptr;
+
+    // Room to run the handler after a stack overflow (installing thread only)
+    alignas(16) char alternateStack[64 * 1024];
+
+    const char* signalName(int signal) {
+        switch (signal) {
+            case SIGSEGV: return "SIGSEGV";
+            case SIGABRT: return "SIGABRT";
+            case SIGBUS: return "SIGBUS";
+            case SIGFPE: return "SIGFPE";
+            default: return "signal";
+        }
+    }
+
+    void onFatalSignal(int signal) {
+        CrashHandler::emergencyFlush(signalName(signal));
+
+        // Hand the signal back to whoever had it before us (usually the
+        // default action); it is blocked here and fires once we return
+        ::sigaction(signal, &previousActions[signal], nullptr);
+        ::raise(signal);
+    }
+
+    [[noreturn]] void onTerminate() {
+        // Not a signal context, so the exception text can be fetched
+        char reason[256] = "std::terminate";
+        if (const std::exception_ptr exception = std::current_exception()) {
+            try {
+                std::rethrow_exception(exception);
+            } catch (const std::exception& e) {
+                std::strncat(reason, " after uncaught exception: ", sizeof(reason) - std::strlen(reason) - 1);
+                std::strncat(reason, e.what(), sizeof(reason) - std::strlen(reason) - 1);
+            } catch (...) {
+                std::strncat(reason, " after uncaught exception", sizeof(reason) - std::strlen(reason) - 1);
+            }
+        }
+        CrashHandler::emergencyFlush(reason);
+
+        if (previousTerminate) {
+            previousTerminate();
+        }
+        std::abort();
+    }
+}
+
+void CrashHandler::install(bool backtrace) {
+    backtraceEnabled.store(backtrace, std::memory_order_relaxed);
+    std::call_once(installed, [] {
+        // backtrace() loads libgcc on first use; do that now, not mid-crash
+        void* frames[1];
+        ::backtrace(frames, 1);
+
+        stack_t current{};
+        if (::sigaltstack(nullptr, &current) == 0 && (current.ss_flags & SS_DISABLE)) {
+            stack_t stack{};
+            stack.ss_sp = alternateStack;
+            stack.ss_size = sizeof(alternateStack);
+            ::sigaltstack(&stack, nullptr);
+        }
+
+        struct sigaction action{};
+        action.sa_handler = onFatalSignal;
+        sigemptyset(&action.sa_mask);
+        action.sa_flags = SA_ONSTACK;
+        for (const int signal : FATAL_SIGNALS) {
+            ::sigaction(signal, &action, &previousActions[signal]);
+        }
+        previousTerminate = std::set_terminate(onTerminate);
+    });
+}
+
+void CrashHandler::registerAppender(IAppender* appender) noexcept {
+    for (auto& slot : registry) {
+        IAppender* expected = nullptr;
+        if (slot.compare_exchange_strong(expected, appender, std::memory_order_release)) {
+            return;
+        }
+    }
+    // Registry full: this appender is simply not flushed on a crash
+}
+
+void CrashHandler::unregisterAppender(IAppender* appender) noexcept {
+    for (auto& slot : registry) {
+        IAppender* expected = appender;
+        if (slot.compare_exchange_strong(expected, nullptr, std::memory_order_release)) {
+            return;
+        }
+    }
+}
+
+void CrashHandler::emergencyFlush(const char* reason) noexcept {
+    if (handled.exchange(true)) {
+        return; // e.g. std::terminate -> abort() -> SIGABRT
+    }
+
+    int fds[kMaxAppenders + 1];
+    std::size_t fdCount = 0;
+    fds[fdCount++] = STDERR_FILENO;
+    for (auto& slot : registry) {
+        IAppender* appender = slot.load(std::memory_order_acquire);
+        if (!appender) continue;
+        const int fd = appender->emergencyFlush();
+        if (fd < 0) continue;
+        bool seen = false;
+        for (std::size_t i = 0; i < fdCount && !seen; ++i) seen = fds[i] == fd;
+        if (!seen) fds[fdCount++] = fd;
+    }
+
+    constexpr char prefix[] = "*** opLog: ";
+    constexpr char suffix[] = ", buffered records flushed ***\n";
+    void* frames[MAX_FRAMES];
+    const int frameCount = backtraceEnabled.load(std::memory_order_relaxed) ? ::backtrace(frames, MAX_FRAMES) : 0;
+    for (std::size_t i = 0; i < fdCount; ++i) {
+        writeAll(fds[i], prefix, sizeof(prefix) - 1);
+        writeAll(fds[i], reason, std::strlen(reason));
+        writeAll(fds[i], suffix, sizeof(suffix) - 1);
+        if (frameCount > 0) {
+            ::backtrace_symbols_fd(frames, frameCount, fds[i]);
+        }
+    }
+}
+
+void CrashHandler::writeAll(int fd, const char* data, std::size_t size) noexcept {
+    while (size > 0) {
+        const ssize_t written = ::write(fd, data, size);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return;
+        }
+        data += written;
+        size -= static_cast<std::size_t>(written);
+    }
+}
@@ -0,0 +1,69 @@
+#include "opLog/ForkHandler.h"
+#include <algorithm>
+#include <mutex>
+#include <vector>
+#include <pthread.h>
+#include "opLog/Config.h"
+#include "opLog/ConfigWatcher.h"
+#include "opLog/LogDispatcher.h"
+#include "opLog/Logger.h"
+#include "opLog/TimeSource.h"
+#include "opLog/appender/RollingFile.h"
+#include "opLog/appender/RotationWorker.h"
+
+namespace {
+    std::mutex registryMutex; // Held from prepare until the fork is over
+    // Never destroyed: a static Logger unregisters after this file's
+    // statics would be gone
+    std::vector<Logger*>& loggers = *new std::vector<Logger*>;
+    std::once_flag installed;
+}
+
+void ForkHandler::prepare() {
+    registryMutex.lock();
+    opLog::Config::mutex_.lock();
+
+    // Quiesce first, while the pool and the appenders can still run
+    for (Logger* logger : loggers) {
+        logger->flush();
+    }
+    for (Logger* logger : loggers) {
+        logger->prepareFork();
+    }
+    RollingFile::prepareFork();
+    LogDispatcher::prepareFork();
+    RotationWorker::getInstance().prepareFork();
+    TimeSource::prepareFork();
+    ConfigWatcher::getInstance().prepareFork();
+}
+
+void ForkHandler::parent() { release(false); }
+void ForkHandler::child() { release(true); }
+
+void ForkHandler::release(bool child) {
+    ConfigWatcher::getInstance().afterFork(child);
+    TimeSource::afterFork(child);
+    RotationWorker::getInstance().afterFork(child);
+    LogDispatcher::afterFork(child);
+    RollingFile::afterFork();
+    for (auto it = loggers.rbegin(); it != loggers.rend(); ++it) {
+        (*it)->afterFork(child);
+    }
+
+    opLog::Config::mutex_.unlock();
+    registryMutex.unlock();
+}
+
+void ForkHandler::install() {
+    std::call_once(installed, [] { ::pthread_atfork(prepare, parent, child); });
+}
+
+void ForkHandler::registerLogger(Logger* logger) {
+    std::lock_guard<std::mutex> lock(registryMutex);
+    loggers.push_back(logger);
+}
+
+void ForkHandler::unregisterLogger(Logger* logger) {
+    std::lock_guard<std::mutex> lock(registryMutex);
+    loggers.erase(std::remove(loggers.begin(), loggers.end(), logger), loggers.end());
+}
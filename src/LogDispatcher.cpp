@@ -0,0 +1,304 @@
+#include "opLog/LogDispatcher.h"
+#include <algorithm>
+#include <iostream>
+#include "opLog/Config.h"
+#include "opLog/ForkHandler.h"
+
+namespace {
+    std::mutex sharedMutex;
+    std::weak_ptr<LogDispatcher> current;
+    std::shared_ptr<LogDispatcher> forking; // Kept alive across fork()
+
+    // What a queued record holds on to; a borrowed payload is the caller's
+    std::size_t recordBytes(const LogRecord& record) {
+        return sizeof(LogRecord) + record.message.capacity() +
+               (record.payload.isBorrowed() ? 0 : record.payload.size());
+    }
+}
+
+LogChannel::LogChannel(LogDispatcher& dispatcher, Consumer consumer, std::size_t capacity)
+    : dispatcher_(dispatcher), consumer_(std::move(consumer)), capacity_(std::max<std::size_t>(capacity, 1)) {}
+
+bool LogChannel::markScheduled() {
+    const bool schedule = !scheduled_;
+    scheduled_ = true;
+    return schedule;
+}
+
+void LogChannel::push(LogRecord record) {
+    bool schedule;
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        changed_.wait(lock, [this] { return queue_.size() < capacity_; });
+        queued_.set(queued_.bytes() + recordBytes(record));
+        queue_.push_back(std::move(record));
+        ++pushed_;
+        schedule = markScheduled();
+    }
+    if (schedule) {
+        dispatcher_.schedule(shared_from_this());
+    }
+}
+
+bool LogChannel::tryPush(LogRecord record) {
+    bool schedule;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (queue_.size() >= capacity_) {
+            return false;
+        }
+        queued_.set(queued_.bytes() + recordBytes(record));
+        queue_.push_back(std::move(record));
+        ++pushed_;
+        schedule = markScheduled();
+    }
+    if (schedule) {
+        dispatcher_.schedule(shared_from_this());
+    }
+    return true;
+}
+
+void LogChannel::whenDrained(std::function<void()> then) {
+    bool schedule;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        barriers_.emplace_back(pushed_, std::move(then));
+        schedule = markScheduled(); // Even when empty: `then` runs on the pool
+    }
+    if (schedule) {
+        dispatcher_.schedule(shared_from_this());
+    }
+}
+
+void LogChannel::drain() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    changed_.wait(lock, [this] { return !scheduled_; });
+}
+
+void LogChannel::prepareFork() {
+    mutex_.lock();
+}
+
+void LogChannel::afterFork(bool child) {
+    if (child) {
+        // Whatever is queued is the parent's to write, and the parent's
+        // coroutines to resume
+        queue_.clear();
+        queued_.set(0);
+        barriers_.clear();
+        pushed_ = consumed_ = 0;
+        scheduled_ = false;
+        ForkHandler::reinitialize(changed_); // Blocked producers are not here
+    }
+    mutex_.unlock();
+}
+
+bool LogChannel::run(std::size_t quantum, std::vector<LogRecord>& batch) {
+    std::size_t count;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        count = std::min(quantum, queue_.size());
+        for (std::size_t i = 0; i < count; ++i) {
+            batch.push_back(std::move(queue_.front()));
+            queue_.pop_front();
+        }
+    }
+    changed_.notify_all(); // Room for blocked producers
+
+    for (const LogRecord& record : batch) {
+        try {
+            consumer_(record);
+        } catch (const std::exception& e) {
+            std::cerr << "LogDispatcher: " << e.what() << std::endl;
+        }
+    }
+    std::size_t bytes = 0;
+    for (const LogRecord& record : batch) {
+        bytes += recordBytes(record);
+    }
+    batch.clear();
+
+    std::vector<std::function<void()>> reached;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        queued_.set(queued_.bytes() - bytes);
+        consumed_ += count;
+        while (!barriers_.empty() && barriers_.front().first <= consumed_) {
+            reached.push_back(std::move(barriers_.front().second));
+            barriers_.pop_front();
+        }
+    }
+    for (auto& then : reached) {
+        try {
+            then();
+        } catch (const std::exception& e) {
+            std::cerr << "LogDispatcher: " << e.what() << std::endl;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!queue_.empty() || !barriers_.empty()) {
+        return true;
+    }
+    scheduled_ = false;
+    changed_.notify_all(); // drain() waiters
+    return false;
+}
+
+LogDispatcher::LogDispatcher(std::size_t workers, std::size_t quantum, std::chrono::milliseconds idle)
+    : quantum_(std::max<std::size_t>(quantum, 1)), idle_(idle) {
+    workers = std::max<std::size_t>(workers, 1);
+    for (std::size_t i = 0; i < workers; ++i) {
+        workers_.push_back(std::make_unique<Worker>());
+    }
+}
+
+LogDispatcher::~LogDispatcher() {
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex_);
+        stop_ = true;
+    }
+    wake_.notify_all();
+    for (auto& worker : workers_) {
+        if (worker->thread.joinable()) {
+            worker->thread.join();
+        }
+    }
+}
+
+std::shared_ptr<LogDispatcher> LogDispatcher::shared() {
+    std::lock_guard<std::mutex> lock(sharedMutex);
+    auto dispatcher = current.lock();
+    if (!dispatcher) {
+        const auto& config = opLog::Config::getInstance();
+        std::size_t workers = config.getAsyncWorkers();
+        if (workers == 0) {
+            workers = std::max(1u, std::thread::hardware_concurrency() / 2);
+        }
+        dispatcher = std::make_shared<LogDispatcher>(workers, config.getAsyncQuantum(),
+                                                     std::chrono::milliseconds(config.getAsyncIdleMs()));
+        current = dispatcher;
+    }
+    return dispatcher;
+}
+
+void LogDispatcher::schedule(std::shared_ptr<LogChannel> channel) {
+    enqueue(nextWorker_.fetch_add(1, std::memory_order_relaxed) % workers_.size(), std::move(channel));
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex_);
+    }
+    wake_.notify_one(); // Whoever wakes may steal it
+}
+
+void LogDispatcher::enqueue(std::size_t index, std::shared_ptr<LogChannel> channel) {
+    Worker& worker = *workers_[index];
+    pending_.fetch_add(1, std::memory_order_release); // Before it can be taken
+    std::lock_guard<std::mutex> lock(worker.mutex);
+    worker.runQueue.push_back(std::move(channel));
+    if (!worker.running) {
+        if (worker.thread.joinable()) {
+            worker.thread.join(); // Retired after idling; already on its way out
+        }
+        worker.running = true;
+        worker.thread = std::thread(&LogDispatcher::runWorker, this, index);
+    }
+}
+
+std::shared_ptr<LogChannel> LogDispatcher::take(std::size_t index) {
+    // Own queue from the front, then steal from the back of the others
+    for (std::size_t i = 0; i < workers_.size(); ++i) {
+        Worker& worker = *workers_[(index + i) % workers_.size()];
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        if (worker.runQueue.empty()) {
+            continue;
+        }
+        std::shared_ptr<LogChannel> channel;
+        if (i == 0) {
+            channel = std::move(worker.runQueue.front());
+            worker.runQueue.pop_front();
+        } else {
+            channel = std::move(worker.runQueue.back());
+            worker.runQueue.pop_back();
+        }
+        pending_.fetch_sub(1, std::memory_order_acq_rel);
+        return channel;
+    }
+    return nullptr;
+}
+
+void LogDispatcher::runWorker(std::size_t index) {
+    std::vector<LogRecord> batch;
+    batch.reserve(quantum_);
+
+    while (true) {
+        if (auto channel = take(index)) {
+            if (channel->run(quantum_, batch)) {
+                // Its turn is over: back of the line behind the other loggers
+                pending_.fetch_add(1, std::memory_order_release);
+                std::lock_guard<std::mutex> lock(workers_[index]->mutex);
+                workers_[index]->runQueue.push_back(std::move(channel));
+            }
+            continue;
+        }
+
+        std::unique_lock<std::mutex> sleepLock(sleepMutex_);
+        const bool woken = wake_.wait_for(sleepLock, idle_, [this] {
+            return pending_.load(std::memory_order_acquire) > 0 || stop_;
+        });
+        const bool stopping = stop_;
+        sleepLock.unlock();
+
+        if (stopping || !woken) {
+            Worker& worker = *workers_[index];
+            std::lock_guard<std::mutex> lock(worker.mutex);
+            if (worker.runQueue.empty() && (stopping || pending_.load(std::memory_order_acquire) == 0)) {
+                worker.running = false; // Idle: let the thread go
+                return;
+            }
+        }
+    }
+}
+
+std::size_t LogDispatcher::runningWorkers() {
+    std::size_t running = 0;
+    for (auto& worker : workers_) {
+        std::lock_guard<std::mutex> lock(worker->mutex);
+        running += worker->running ? 1 : 0;
+    }
+    return running;
+}
+
+void LogDispatcher::prepareFork() {
+    sharedMutex.lock();
+    forking = current.lock();
+    if (!forking) {
+        return;
+    }
+    forking->sleepMutex_.lock();
+    for (auto& worker : forking->workers_) {
+        worker->mutex.lock();
+    }
+}
+
+void LogDispatcher::afterFork(bool child) {
+    if (forking) {
+        for (auto it = forking->workers_.rbegin(); it != forking->workers_.rend(); ++it) {
+            Worker& worker = **it;
+            if (child) {
+                ForkHandler::reinitialize(worker.thread);
+                worker.runQueue.clear();
+                worker.running = false;
+            }
+            worker.mutex.unlock();
+        }
+        if (child) {
+            forking->pending_.store(0, std::memory_order_relaxed);
+            ForkHandler::reinitialize(forking->wake_);
+        }
+        forking->sleepMutex_.unlock();
+    }
+    // Not reset under the lock: if this was the last reference, the
+    // destructor joins the workers
+    std::shared_ptr<LogDispatcher> dispatcher = std::move(forking);
+    sharedMutex.unlock();
+}
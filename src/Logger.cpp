@@ -3,7 +3,17 @@
 #include "opLog/LogRecord.h"
 #include "opLog/formatter/PlainTextFormatter.h"
 #include "opLog/appender/FileAppender.h"
+#include "opLog/BacktraceRing.h"
+#include "opLog/CrashHandler.h"
+#include "opLog/ForkHandler.h"
+#include "opLog/LogDispatcher.h"
+#include "opLog/MemoryBudget.h"
+#include "opLog/TimeSource.h"
+#include "opLog/appender/BinaryFileAppender.h"
 #include "opLog/appender/ConsoleAppender.h"
+#include "opLog/appender/IoUringFileAppender.h"
+#include "opLog/appender/ShardedFileAppender.h"
+#include "opLog/appender/ShmRingAppender.h"
 #include <chrono>
 #include <iostream>
 #include <memory>
@@ -12,21 +22,82 @@
 std::unique_ptr<Logger> Logger::instance_ = nullptr;
 std::once_flag Logger::instanceFlag_;
 
+namespace {
+    std::unique_ptr<IAppender> makeFileAppender() {
+        const auto& config = opLog::Config::getInstance();
+        if (config.isShmRingEnabled()) {
+            return std::make_unique<ShmRingAppender>(); // oplog-collector owns the files
+        }
+        if (config.isBinaryFormat()) {
+            return std::make_unique<BinaryFileAppender>();
+        }
+        if (config.isFileShardingEnabled()) {
+            return std::make_unique<ShardedFileAppender>();
+        }
+        if (config.isIoUringEnabled()) {
+            return std::make_unique<IoUringFileAppender>();
+        }
+        return std::make_unique<FileAppender>();
+    }
+}
+
 Logger::Logger(std::unique_ptr<IFormatter> formatter,
-               std::vector<std::unique_ptr<IAppender>> appenders)
-    : formatter_(std::move(formatter)), appenders_(std::move(appenders)) {
+               std::vector<std::unique_ptr<IAppender>> appenders) {
+    auto snapshot = std::make_shared<Snapshot>();
+    snapshot->formatter = std::move(formatter);
 
     // Set default formatter if none provided
-    if (!formatter_) {
-        formatter_ = std::make_unique<PlainTextFormatter>();
+    if (!snapshot->formatter) {
+        snapshot->formatter = std::make_shared<PlainTextFormatter>();
     }
 
     // Add default console appender if no appenders provided
-    if (appenders_.empty()) {
-        appenders_.push_back(std::make_unique<ConsoleAppender>());
+    if (appenders.empty()) {
+        appenders.push_back(std::make_unique<ConsoleAppender>());
+    }
+
+    for (auto& appender : appenders) {
+        CrashHandler::registerAppender(appender.get());
+        auto slot = std::make_shared<AppenderSlot>();
+        slot->appender = std::move(appender);
+        snapshot->appenders.push_back(std::move(slot));
+    }
+    snapshot_.store(std::move(snapshot));
+
+    const auto& config = opLog::Config::getInstance();
+    if (config.getBacktraceSize() > 0) {
+        backtrace_ = std::make_unique<BacktraceRing>(config.getBacktraceSize());
+        backtraceTrigger_ = config.getBacktraceTriggerLevel();
+    }
+    if (config.isCrashHandlerEnabled()) {
+        CrashHandler::install(config.isCrashBacktraceEnabled());
+    }
+    async_ = config.isAsyncLogging();
+    dispatcher_ = LogDispatcher::shared(); // Workers only start once there is work
+    channel_ = std::make_shared<LogChannel>(*dispatcher_, [this](const LogRecord& record) { writeRecord(record); },
+                                            config.getAsyncQueueRecords());
+    if (config.isForkSafe()) {
+        ForkHandler::install();
+        ForkHandler::registerLogger(this);
+    }
+}
+
+Logger::~Logger() {
+    ForkHandler::unregisterLogger(this);
+    channel_->drain(); // The pool must be done with us before members go
+    for (const auto& slot : snapshot_.load()->appenders) {
+        CrashHandler::unregisterAppender(slot->appender.get());
     }
 }
 
+template<typename Update>
+void Logger::updateSnapshot(Update&& update) {
+    std::lock_guard<std::mutex> lock(updateMutex_);
+    auto next = std::make_shared<Snapshot>(*snapshot_.load());
+    update(*next);
+    snapshot_.store(std::move(next));
+}
+
 Logger& Logger::getInstance() {
     std::call_once(instanceFlag_, []() {
         // Initialize config
@@ -34,7 +105,7 @@ Logger& Logger::getInstance() {
 
         auto formatter = std::make_unique<PlainTextFormatter>();
         std::vector<std::unique_ptr<IAppender>> appenders;
-        appenders.push_back(std::make_unique<FileAppender>());
+        appenders.push_back(makeFileAppender());
 
         // Create Logger directly instead of using createFileLogger()
         instance_ = std::make_unique<Logger>(std::move(formatter), std::move(appenders));
@@ -53,7 +124,7 @@ Logger Logger::createFileLogger(const std::string& configPath) {
     auto formatter = std::make_unique<PlainTextFormatter>();
 
     std::vector<std::unique_ptr<IAppender>> appenders;
-    appenders.push_back(std::make_unique<FileAppender>());
+    appenders.push_back(makeFileAppender());
 
     return {std::move(formatter), std::move(appenders)};
 }
@@ -74,7 +145,7 @@ Logger Logger::createDualLogger() {
     auto formatter = std::make_unique<PlainTextFormatter>();
 
     std::vector<std::unique_ptr<IAppender>> appenders;
-    appenders.push_back(std::make_unique<FileAppender>());
+    appenders.push_back(makeFileAppender());
     appenders.push_back(std::make_unique<ConsoleAppender>());
 
     return {std::move(formatter), std::move(appenders)};
@@ -87,27 +158,132 @@ bool Logger::shouldLog(LogLevel level) const {
 
 void Logger::log(LogLevel level, const std::string& message) const {
     if (!shouldLog(level)) {
+        if (backtrace_) {
+            backtrace_->push(level, message, TimeSource::now());
+        }
         return; // Filter out based on config
     }
-
-    // Thread-safe logging
-    std::lock_guard<std::mutex> lock(logMutex_);
+    if (!MemoryBudget::admit(level)) {
+        return; // Over memory_budget
+    }
 
     // Create log record
-    const LogRecord record{level, message, std::chrono::system_clock::now()};
+    LogRecord record{level, message, TimeSource::now()};
+    if (async_) {
+        channel_->push(std::move(record));
+    } else {
+        writeRecord(record);
+    }
+}
+
+void Logger::log(LogLevel level, const std::string& message, Payload payload) const {
+    if (!shouldLog(level)) {
+        if (backtrace_) {
+            backtrace_->push(level, message, TimeSource::now());
+        }
+        return;
+    }
+    if (!MemoryBudget::admit(level)) {
+        return;
+    }
+
+    if (const std::size_t limit = opLog::Config::getInstance().getPayloadMaxBytes()) {
+        payload.truncate(limit);
+    }
+    LogRecord record{level, message, TimeSource::now(), std::move(payload)};
+    if (async_) {
+        record.payload = record.payload.shared(); // The caller's bytes are gone by the time it is written
+        channel_->push(std::move(record));
+    } else {
+        writeRecord(record);
+    }
+}
+
+bool Logger::tryLog(LogLevel level, std::string message) const {
+    if (!shouldLog(level)) {
+        if (backtrace_) {
+            backtrace_->push(level, message, TimeSource::now());
+        }
+        return true;
+    }
+    if (!MemoryBudget::admit(level)) {
+        return false;
+    }
+    return channel_->tryPush(LogRecord{level, std::move(message), TimeSource::now()});
+}
+
+void Logger::writeRecord(const LogRecord& record) const {
+    const LogLevel level = record.logLevel;
+
+    // No lock: the snapshot stays valid for as long as we hold it
+    const std::shared_ptr<const Snapshot> snapshot = snapshot_.load(std::memory_order_acquire);
+
+    // Context first: the held records led up to this one
+    if (backtrace_ && level >= backtraceTrigger_) {
+        writeBacktrace(*snapshot);
+    }
 
     // Format the message
-    const std::string formatted = formatter_->format(record);
+    const std::string formatted = snapshot->formatter->format(record);
 
     // Skip empty formatted messages (filtered by formatter)
     if (formatted.empty()) {
         return;
     }
 
+    {
+        const MemoryBudget::Account line(formatted.capacity());
+        writeToAppenders(*snapshot, record, formatted);
+    }
+
+    if (MemoryBudget::pressure() != MemoryBudget::Pressure::NORMAL) {
+        flushAppenders(); // Write through so appender buffers are given back
+    }
+}
+
+void Logger::writeBacktrace(const Snapshot& snapshot) const {
+    std::lock_guard<std::mutex> lock(backtraceMutex_);
+    backtrace_->drain([&snapshot](const BacktraceRing::Entry& entry) {
+        const LogRecord record{entry.level, entry.message, entry.timestamp};
+        writeToAppenders(snapshot, record, snapshot.formatter->formatUnfiltered(record));
+    });
+}
+
+void Logger::dumpBacktrace() const {
+    if (!backtrace_) {
+        return;
+    }
+    channel_->drain(); // After what was logged before the call
+    writeBacktrace(*snapshot_.load(std::memory_order_acquire));
+}
+
+void Logger::writeToAppenders(const Snapshot& snapshot, const LogRecord& record, const std::string& formatted) {
+    // For appenders that cannot write a payload themselves: the payload as
+    // part of the message, built once for all of them
+    std::unique_ptr<LogRecord> joined;
+    std::string joinedFormatted;
+
     // Write to all appenders
-    for (const auto& appender : appenders_) {
+    for (const auto& slot : snapshot.appenders) {
         try {
-            appender->write(formatted);
+            const LogRecord* target = &record;
+            const std::string* text = &formatted;
+            if (record.payload && !slot->appender->writesPayloads()) {
+                if (!joined) {
+                    joined = std::make_unique<LogRecord>(LogRecord{record.logLevel, record.message, record.timestamp});
+                    record.payload.appendTo(joined->message);
+                    joinedFormatted = snapshot.formatter->formatUnfiltered(*joined);
+                }
+                target = joined.get();
+                text = &joinedFormatted;
+            }
+
+            if (slot->appender->isThreadSafe()) {
+                slot->appender->write(*target, *text);
+            } else {
+                std::lock_guard<std::mutex> lock(slot->mutex);
+                slot->appender->write(*target, *text);
+            }
         } catch (const std::exception& e) {
             // Log to stderr if appender fails (avoid infinite recursion)
             std::cerr << "Logger: Appender error: " << e.what() << std::endl;
@@ -120,41 +296,114 @@ void Logger::debug(const std::string& message) const { log(LogLevel::DEBUG, mess
 void Logger::info(const std::string& message) const { log(LogLevel::INFO, message); }
 void Logger::warn(const std::string& message) const { log(LogLevel::WARN, message); }
 void Logger::error(const std::string& message) const { log(LogLevel::ERROR, message); }
-void Logger::fatal(const std::string& message) const { log(LogLevel::FATAL, message); }
+void Logger::fatal(const std::string& message) const {
+    log(LogLevel::FATAL, message);
+    flush(); // A fatal record is often the last thing the process does
+}
 
 void Logger::addAppender(std::unique_ptr<IAppender> appender) {
-    std::lock_guard<std::mutex> lock(logMutex_);
-    appenders_.push_back(std::move(appender));
+    CrashHandler::registerAppender(appender.get());
+    auto slot = std::make_shared<AppenderSlot>();
+    slot->appender = std::move(appender);
+    updateSnapshot([&slot](Snapshot& snapshot) { snapshot.appenders.push_back(std::move(slot)); });
 }
 
 void Logger::clearAppenders() {
-    std::lock_guard<std::mutex> lock(logMutex_);
-    appenders_.clear();
+    updateSnapshot([](Snapshot& snapshot) {
+        for (const auto& slot : snapshot.appenders) {
+            CrashHandler::unregisterAppender(slot->appender.get());
+        }
+        // Appenders still in use by a log() call are destroyed when it finishes
+        snapshot.appenders.clear();
+    });
 }
 
 size_t Logger::getAppenderCount() const {
-    std::lock_guard<std::mutex> lock(logMutex_);
-    return appenders_.size();
+    return snapshot_.load(std::memory_order_acquire)->appenders.size();
 }
 
 void Logger::setFormatter(std::unique_ptr<IFormatter> formatter) {
-    std::lock_guard<std::mutex> lock(logMutex_);
-    formatter_ = std::move(formatter);
+    std::shared_ptr<IFormatter> shared(std::move(formatter));
+    updateSnapshot([&shared](Snapshot& snapshot) { snapshot.formatter = std::move(shared); });
 }
 
-void Logger::reloadConfig() {
-    auto& config = opLog::Config::getInstance();
-    config.reloadConfig();
+bool Logger::reloadConfig() {
+    // Formatters read the published settings per record and appenders
+    // refresh theirs on their next write, so the formatter stays
+    return opLog::Config::getInstance().reloadConfig();
+}
 
-    // TODO: recreate formatters/appenders
-    // For example, update formatter style based on new config
-    if (formatter_) {
-        formatter_ = std::make_unique<PlainTextFormatter>();
+void Logger::flush() const {
+    channel_->drain();
+    flushAppenders();
+}
+
+void Logger::flushAppenders() const {
+    const std::shared_ptr<const Snapshot> snapshot = snapshot_.load(std::memory_order_acquire);
+    for (const auto& slot : snapshot->appenders) {
+        try {
+            std::lock_guard<std::mutex> lock(slot->mutex);
+            slot->appender->flush();
+        } catch (const std::exception& e) {
+            std::cerr << "Logger: Appender error: " << e.what() << std::endl;
+        }
     }
 }
 
-void Logger::flush() const {
-    // TODO: implement IFlushable interface if appenders support flushing.
-    std::lock_guard<std::mutex> lock(logMutex_);
-    // Future: call flush() on each appender that supports it
-}
\ No newline at end of file
+void Logger::setExecutor(Executor executor) {
+    updateSnapshot([&executor](Snapshot& snapshot) { snapshot.executor = std::move(executor); });
+}
+
+void Logger::resumeWhenFlushed(std::coroutine_handle<> handle) const {
+    // Records from log() on a logger without async_logging are already
+    // written; the pool still does the flushing, off the caller's thread
+    channel_->whenDrained([this, handle] {
+        flushAppenders();
+        const std::shared_ptr<const Snapshot> snapshot = snapshot_.load(std::memory_order_acquire);
+        if (snapshot->executor) {
+            snapshot->executor(handle);
+        } else {
+            handle.resume();
+        }
+    });
+}
+
+void FlushAwaitable::await_suspend(std::coroutine_handle<> handle) const {
+    logger_.resumeWhenFlushed(handle); // May resume before this returns
+}
+
+void Logger::prepareFork() {
+    updateMutex_.lock();
+    backtraceMutex_.lock();
+    if (backtrace_) {
+        backtrace_->prepareFork();
+    }
+    channel_->prepareFork();
+    forkSnapshot_ = snapshot_.load(std::memory_order_acquire);
+    for (const auto& slot : forkSnapshot_->appenders) {
+        slot->mutex.lock();
+        slot->appender->prepareFork();
+    }
+}
+
+void Logger::afterFork(bool child) {
+    for (auto it = forkSnapshot_->appenders.rbegin(); it != forkSnapshot_->appenders.rend(); ++it) {
+        const auto& slot = *it;
+        try {
+            slot->appender->afterFork(child);
+        } catch (const std::exception& e) {
+            std::cerr << "Logger: Appender error after fork: " << e.what() << std::endl;
+        }
+        slot->mutex.unlock();
+    }
+    if (child) {
+        ForkHandler::reinitialize(snapshot_, forkSnapshot_); // Unlocked, should a load have been cut short
+    }
+    forkSnapshot_.reset();
+    channel_->afterFork(child);
+    if (backtrace_) {
+        backtrace_->afterFork();
+    }
+    backtraceMutex_.unlock();
+    updateMutex_.unlock();
+}
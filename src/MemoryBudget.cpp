@@ -0,0 +1,67 @@
+#include "opLog/MemoryBudget.h"
+#include "opLog/Config.h"
+
+MemoryBudget::Shard MemoryBudget::shards_[MemoryBudget::kShards];
+std::atomic<std::int64_t> MemoryBudget::total_{0};
+std::atomic<std::int64_t> MemoryBudget::peak_{0};
+std::atomic<std::uint64_t> MemoryBudget::shed_{0};
+
+namespace {
+    std::atomic<std::size_t> nextShard{0};
+}
+
+MemoryBudget::Shard& MemoryBudget::shard() {
+    // Threads are dealt out round-robin, which spreads them better than a hash of the id
+    thread_local const std::size_t index = nextShard.fetch_add(1, std::memory_order_relaxed) % kShards;
+    return shards_[index];
+}
+
+void MemoryBudget::fold(Shard& shard) {
+    const std::int64_t pending = shard.pending.exchange(0, std::memory_order_relaxed);
+    const std::int64_t total = total_.fetch_add(pending, std::memory_order_relaxed) + pending;
+    std::int64_t peak = peak_.load(std::memory_order_relaxed);
+    while (total > peak && !peak_.compare_exchange_weak(peak, total, std::memory_order_relaxed)) {}
+}
+
+MemoryBudget::Pressure MemoryBudget::pressure() {
+    const auto& config = opLog::Config::getInstance();
+    const std::size_t limit = config.getMemoryBudget();
+    if (limit == 0) {
+        return Pressure::NORMAL;
+    }
+    const std::int64_t total = total_.load(std::memory_order_relaxed);
+    if (total >= static_cast<std::int64_t>(limit)) {
+        return Pressure::SHED;
+    }
+    if (total * 100 >= static_cast<std::int64_t>(limit * config.getMemoryFlushPercent())) {
+        return Pressure::FLUSH;
+    }
+    return Pressure::NORMAL;
+}
+
+bool MemoryBudget::admit(LogLevel level) {
+    if (level >= opLog::Config::getInstance().getMemoryShedLevel() || pressure() != Pressure::SHED) {
+        return true;
+    }
+    shed_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+MemoryBudget::Usage MemoryBudget::usage() {
+    std::int64_t current = total_.load(std::memory_order_relaxed);
+    for (const Shard& shard : shards_) {
+        current += shard.pending.load(std::memory_order_relaxed);
+    }
+    current = current < 0 ? 0 : current;
+    const std::int64_t peak = peak_.load(std::memory_order_relaxed);
+    return {
+        static_cast<std::size_t>(current),
+        static_cast<std::size_t>(peak > current ? peak : current),
+        opLog::Config::getInstance().getMemoryBudget(),
+        shed_.load(std::memory_order_relaxed),
+    };
+}
+
+void MemoryBudget::resetPeak() {
+    peak_.store(total_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+}
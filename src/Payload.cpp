@@ -0,0 +1,183 @@
+#include "opLog/Payload.h"
+#include <algorithm>
+#include <cstring>
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+namespace {
+    constexpr char HEX_DIGITS[] = "0123456789abcdef";
+    constexpr char BASE64_ALPHABET[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+    void hexScalar(const unsigned char* in, std::size_t size, char* out) {
+        for (std::size_t i = 0; i < size; ++i) {
+            out[2 * i] = HEX_DIGITS[in[i] >> 4];
+            out[2 * i + 1] = HEX_DIGITS[in[i] & 0x0f];
+        }
+    }
+
+    void base64Scalar(const unsigned char* in, std::size_t size, char* out) {
+        std::size_t i = 0;
+        for (; i + 3 <= size; i += 3) {
+            const std::uint32_t triple = (in[i] << 16) | (in[i + 1] << 8) | in[i + 2];
+            *out++ = BASE64_ALPHABET[(triple >> 18) & 0x3f];
+            *out++ = BASE64_ALPHABET[(triple >> 12) & 0x3f];
+            *out++ = BASE64_ALPHABET[(triple >> 6) & 0x3f];
+            *out++ = BASE64_ALPHABET[triple & 0x3f];
+        }
+        if (i < size) {
+            const std::uint32_t triple = (in[i] << 16) | (i + 1 < size ? in[i + 1] << 8 : 0);
+            *out++ = BASE64_ALPHABET[(triple >> 18) & 0x3f];
+            *out++ = BASE64_ALPHABET[(triple >> 12) & 0x3f];
+            *out++ = i + 1 < size ? BASE64_ALPHABET[(triple >> 6) & 0x3f] : '=';
+            *out++ = '=';
+        }
+    }
+
+#if defined(__x86_64__)
+    // SSE2 is part of x86-64: 16 bytes become 32 digits per step.
+    // Returns how many input bytes were encoded.
+    std::size_t hexSse2(const unsigned char* in, std::size_t size, char* out) {
+        const __m128i mask = _mm_set1_epi8(0x0f);
+        const __m128i nine = _mm_set1_epi8(9);
+        const __m128i zero = _mm_set1_epi8('0');
+        const __m128i letters = _mm_set1_epi8('a' - '0' - 10);
+
+        std::size_t i = 0;
+        for (; i + 16 <= size; i += 16) {
+            const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+            __m128i high = _mm_and_si128(_mm_srli_epi16(bytes, 4), mask);
+            __m128i low = _mm_and_si128(bytes, mask);
+            high = _mm_add_epi8(_mm_add_epi8(high, zero), _mm_and_si128(_mm_cmpgt_epi8(high, nine), letters));
+            low = _mm_add_epi8(_mm_add_epi8(low, zero), _mm_and_si128(_mm_cmpgt_epi8(low, nine), letters));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 2 * i), _mm_unpacklo_epi8(high, low));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 2 * i + 16), _mm_unpackhi_epi8(high, low));
+        }
+        return i;
+    }
+
+    // 12 bytes become 16 characters per step (W. Mula's pshufb method).
+    // Loads 16 bytes, so it stops while at least 16 remain.
+    __attribute__((target("ssse3")))
+    std::size_t base64Ssse3(const unsigned char* in, std::size_t size, char* out) {
+        const __m128i spread = _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1);
+        const __m128i shiftLut = _mm_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                               '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62,
+                                               '/' - 63, 'A', 0, 0);
+
+        std::size_t i = 0;
+        for (; i + 16 <= size; i += 12, out += 16) {
+            const __m128i bytes = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i)), spread);
+
+            // Four 6-bit indices per 3 input bytes, one per output byte
+            const __m128i t0 = _mm_and_si128(bytes, _mm_set1_epi32(0x0fc0fc00));
+            const __m128i t1 = _mm_mulhi_epu16(t0, _mm_set1_epi32(0x04000040));
+            const __m128i t2 = _mm_and_si128(bytes, _mm_set1_epi32(0x003f03f0));
+            const __m128i t3 = _mm_mullo_epi16(t2, _mm_set1_epi32(0x01000010));
+            const __m128i indices = _mm_or_si128(t1, t3);
+
+            // Offset to add per range: A-Z, a-z, 0-9, '+', '/'
+            __m128i range = _mm_subs_epu8(indices, _mm_set1_epi8(51));
+            const __m128i upper = _mm_cmpgt_epi8(_mm_set1_epi8(26), indices);
+            range = _mm_or_si128(range, _mm_and_si128(upper, _mm_set1_epi8(13)));
+            const __m128i chars = _mm_add_epi8(_mm_shuffle_epi8(shiftLut, range), indices);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out), chars);
+        }
+        return i;
+    }
+
+    bool hasSsse3() {
+        static const bool supported = (__builtin_cpu_init(), __builtin_cpu_supports("ssse3") != 0);
+        return supported;
+    }
+#endif
+}
+
+Payload Payload::borrow(const void* data, std::size_t size, Encoding encoding) {
+    Payload payload;
+    payload.data_ = static_cast<const unsigned char*>(data);
+    payload.size_ = size;
+    payload.encoding_ = encoding;
+    return payload;
+}
+
+Payload Payload::share(std::shared_ptr<const void> owner, const void* data, std::size_t size, Encoding encoding) {
+    Payload payload = borrow(data, size, encoding);
+    payload.owner_ = std::move(owner);
+    return payload;
+}
+
+Payload Payload::share(std::shared_ptr<const std::string> bytes, Encoding encoding) {
+    const std::string& text = *bytes;
+    return share(std::move(bytes), text.data(), text.size(), encoding);
+}
+
+Payload& Payload::truncate(std::size_t maxBytes) {
+    if (size_ > maxBytes) {
+        omitted_ += size_ - maxBytes;
+        size_ = maxBytes;
+    }
+    return *this;
+}
+
+Payload Payload::shared() const {
+    if (!isBorrowed()) {
+        return *this;
+    }
+    auto copy = std::make_shared<std::string>(reinterpret_cast<const char*>(data_), size_);
+    Payload payload = share(std::move(copy), encoding_);
+    payload.omitted_ = omitted_;
+    return payload;
+}
+
+std::size_t Payload::renderedSize() const {
+    switch (encoding_) {
+        case Encoding::RAW: return size_;
+        case Encoding::HEX: return 2 * size_;
+        case Encoding::BASE64: return base64Size(size_);
+    }
+    return size_;
+}
+
+void Payload::render(char* out) const {
+    switch (encoding_) {
+        case Encoding::RAW:
+            std::memcpy(out, data_, size_);
+            break;
+        case Encoding::HEX:
+            encodeHex(data_, size_, out);
+            break;
+        case Encoding::BASE64:
+            encodeBase64(data_, size_, out);
+            break;
+    }
+}
+
+std::string Payload::note() const {
+    return omitted_ == 0 ? std::string() : " (+" + std::to_string(omitted_) + " bytes)";
+}
+
+void Payload::appendTo(std::string& line) const {
+    const std::size_t start = line.size() + 1;
+    line.resize(start + renderedSize(), ' ');
+    render(line.data() + start);
+    line.append(note());
+}
+
+void Payload::encodeHex(const unsigned char* data, std::size_t size, char* out) {
+    std::size_t done = 0;
+#if defined(__x86_64__)
+    done = hexSse2(data, size, out);
+#endif
+    hexScalar(data + done, size - done, out + 2 * done);
+}
+
+void Payload::encodeBase64(const unsigned char* data, std::size_t size, char* out) {
+    std::size_t done = 0;
+#if defined(__x86_64__)
+    if (hasSsse3()) {
+        done = base64Ssse3(data, size, out);
+    }
+#endif
+    base64Scalar(data + done, size - done, out + done / 3 * 4);
+}
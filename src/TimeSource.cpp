@@ -0,0 +1,195 @@
+#include "opLog/TimeSource.h"
+#include <algorithm>
+#include <condition_variable>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include "opLog/ForkHandler.h"
+#if defined(__x86_64__)
+#include <cpuid.h>
+#endif
+
+std::atomic<ClockSource> TimeSource::mode_{ClockSource::PRECISE};
+std::atomic<std::uint64_t> TimeSource::seq_{0};
+std::atomic<std::uint64_t> TimeSource::baseTicks_{0};
+std::atomic<std::int64_t> TimeSource::baseNs_{0};
+std::atomic<std::uint64_t> TimeSource::nsPerTick_{0};
+
+namespace {
+    std::int64_t realtimeNs() {
+        timespec ts{};
+        ::clock_gettime(CLOCK_REALTIME, &ts);
+        return static_cast<std::int64_t>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+    }
+}
+
+// Owns the calibration thread. Each round pairs a TSC reading with
+// CLOCK_REALTIME (taking the tightest of a few attempts) and derives the
+// rate from the first pair, so it gets more precise the longer it runs.
+class TscCalibrator {
+private:
+    struct Sample {
+        std::uint64_t ticks;
+        std::int64_t ns;
+    };
+
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    bool stop_{false};
+    std::chrono::milliseconds interval_;
+    Sample origin_{};
+    bool continuous_; // Readers are on the published calibration; never step back from it
+    std::thread thread_;
+
+    static Sample sample() {
+#if defined(__x86_64__)
+        Sample best{};
+        std::uint64_t bestWindow = UINT64_MAX;
+        for (int i = 0; i < 5; ++i) {
+            const std::uint64_t before = __rdtsc();
+            const std::int64_t ns = realtimeNs();
+            const std::uint64_t after = __rdtsc();
+            if (after - before < bestWindow) {
+                bestWindow = after - before;
+                best = {before + (after - before) / 2, ns};
+            }
+        }
+        return best;
+#else
+        return {0, realtimeNs()};
+#endif
+    }
+
+    void publish(const Sample& now) {
+        const auto elapsedNs = static_cast<unsigned __int128>(now.ns - origin_.ns);
+        const std::uint64_t elapsedTicks = now.ticks - origin_.ticks;
+        if (elapsedTicks == 0) {
+            return;
+        }
+        auto nsPerTick = static_cast<std::uint64_t>((elapsedNs << 32) / elapsedTicks);
+
+        const std::uint64_t seq = TimeSource::seq_.load(std::memory_order_relaxed);
+        TimeSource::seq_.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst); // Readers past this tick retry
+#if defined(__x86_64__)
+        const std::uint64_t ticks = __rdtsc();
+#else
+        const std::uint64_t ticks = now.ticks;
+#endif
+        std::int64_t baseNs = TimeSource::project(now.ticks, now.ns, nsPerTick, ticks);
+        if (continuous_) {
+            // Start no earlier than where the last calibration has got to,
+            // and slow down so the next round meets the system clock again
+            const std::int64_t current = TimeSource::project(
+                TimeSource::baseTicks_.load(std::memory_order_relaxed), TimeSource::baseNs_.load(std::memory_order_relaxed),
+                TimeSource::nsPerTick_.load(std::memory_order_relaxed), ticks);
+            if (current > baseNs) {
+                const auto intervalNs = std::max<std::int64_t>(
+                    std::chrono::duration_cast<std::chrono::nanoseconds>(interval_).count(), 1);
+                const auto slowdown = static_cast<unsigned __int128>(current - baseNs) * nsPerTick /
+                                      static_cast<unsigned __int128>(intervalNs);
+                nsPerTick -= static_cast<std::uint64_t>(std::min<unsigned __int128>(slowdown, nsPerTick / 2));
+                baseNs = current;
+            }
+        }
+        continuous_ = true;
+
+        TimeSource::baseTicks_.store(ticks, std::memory_order_relaxed);
+        TimeSource::baseNs_.store(baseNs, std::memory_order_relaxed);
+        TimeSource::nsPerTick_.store(nsPerTick, std::memory_order_relaxed);
+        TimeSource::seq_.store(seq + 2, std::memory_order_release);
+    }
+
+    void run() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (!wake_.wait_for(lock, interval_, [this] { return stop_; })) {
+            publish(sample());
+        }
+    }
+
+public:
+    explicit TscCalibrator(std::chrono::milliseconds interval)
+        : interval_(interval), continuous_(TimeSource::current() == ClockSource::TSC) {
+        // A first rate from a short window, good enough until the next round
+        origin_ = sample();
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        publish(sample());
+        thread_ = std::thread(&TscCalibrator::run, this);
+    }
+
+    void prepareFork() {
+        mutex_.lock();
+    }
+
+    void afterFork(bool child) {
+        if (child) {
+            ForkHandler::reinitialize(thread_);
+            ForkHandler::reinitialize(wake_);
+        }
+        mutex_.unlock();
+        if (child) {
+            thread_ = std::thread(&TscCalibrator::run, this);
+        }
+    }
+
+    std::chrono::milliseconds interval() const { return interval_; }
+
+    ~TscCalibrator() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        wake_.notify_all();
+        thread_.join();
+    }
+};
+
+namespace {
+    std::mutex selectMutex;
+    std::unique_ptr<TscCalibrator> calibrator;
+}
+
+bool TimeSource::tscAvailable() {
+#if defined(__x86_64__)
+    unsigned eax, ebx, ecx, edx;
+    // Invariant TSC: constant rate across P-/C-states
+    return __get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx) && (edx & (1u << 8)) != 0;
+#else
+    return false;
+#endif
+}
+
+void TimeSource::select(ClockSource source, long long calibrationMs) {
+    std::lock_guard<std::mutex> lock(selectMutex);
+    if (source == ClockSource::TSC && !tscAvailable()) {
+        std::cerr << "Warning: no invariant TSC, using the coarse clock" << std::endl;
+        source = ClockSource::COARSE;
+    }
+
+    if (source == ClockSource::TSC) {
+        if (!calibrator || calibrator->interval() != std::chrono::milliseconds(calibrationMs)) {
+            calibrator.reset(); // Readers keep the last calibration meanwhile
+            calibrator = std::make_unique<TscCalibrator>(std::chrono::milliseconds(calibrationMs));
+        }
+    } else if (calibrator) {
+        mode_.store(source, std::memory_order_relaxed);
+        calibrator.reset();
+        return;
+    }
+    mode_.store(source, std::memory_order_relaxed);
+}
+
+void TimeSource::prepareFork() {
+    selectMutex.lock();
+    if (calibrator) {
+        calibrator->prepareFork();
+    }
+}
+
+void TimeSource::afterFork(bool child) {
+    if (calibrator) {
+        calibrator->afterFork(child);
+    }
+    selectMutex.unlock();
+}
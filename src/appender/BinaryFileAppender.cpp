@@ -0,0 +1,176 @@
+#include "opLog/appender/BinaryFileAppender.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include "opLog/Config.h"
+#include "opLog/ForkHandler.h"
+#include "opLog/binary/BinaryLogFormat.h"
+
+BinaryFileAppender::BinaryFileAppender() : file_("-log.oplb") {
+    const auto& config = opLog::Config::getInstance();
+    blockRecords_ = std::max<size_t>(1, config.getBinaryBlockRecords());
+    blockBytes_ = config.getBinaryBlockBytes();
+    blockInterval_ = std::chrono::milliseconds(config.getBinaryBlockIntervalMs());
+    timestamps_.reserve(blockRecords_);
+    levels_.reserve(blockRecords_);
+    messageIds_.reserve(blockRecords_);
+
+    if (blockInterval_.count() > 0) {
+        timer_ = std::thread(&BinaryFileAppender::runTimer, this);
+    }
+}
+
+BinaryFileAppender::~BinaryFileAppender() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    timerCv_.notify_all();
+    if (timer_.joinable()) {
+        timer_.join();
+    }
+
+    try {
+        flushBlock();
+    } catch (const std::exception& e) {
+        std::cerr << "BinaryFileAppender error: " << e.what() << std::endl;
+    }
+}
+
+void BinaryFileAppender::write(const std::string& message) {
+    write(LogRecord{LogLevel::INFO, message, std::chrono::system_clock::now()}, message);
+}
+
+void BinaryFileAppender::write(const LogRecord& record, const std::string& message) {
+    (void)message;
+    std::lock_guard<std::mutex> lock(mutex_);
+    const auto timestampNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        record.timestamp.time_since_epoch()).count();
+
+    if (file_.rolloverDue(timestampNs)) {
+        flushBlock(); // Blocks never straddle files
+        file_.roll(timestampNs);
+    }
+
+    if (timestamps_.empty()) {
+        blockSince_ = std::chrono::steady_clock::now();
+    }
+    const auto [entry, inserted] = dictionary_.try_emplace(record.message,
+                                                            static_cast<std::uint32_t>(dictionaryOrder_.size()));
+    if (inserted) {
+        dictionaryOrder_.push_back(&entry->first);
+        dictionaryBytes_ += record.message.size();
+    }
+    timestamps_.push_back(timestampNs);
+    levels_.push_back(static_cast<char>(record.logLevel));
+    messageIds_.push_back(entry->second);
+
+    if (timestamps_.size() >= blockRecords_ || dictionaryBytes_ >= blockBytes_) {
+        flushBlock();
+    }
+    trackMemory();
+}
+
+void BinaryFileAppender::flush() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    flushBlock();
+    file_.flush();
+    trackMemory();
+}
+
+void BinaryFileAppender::trackMemory() {
+    constexpr size_t kDictionaryNode = sizeof(std::string) + 4 * sizeof(void*); // Key, id, hash bucket and link
+    memory_.set(timestamps_.capacity() * sizeof(long long) + levels_.capacity() +
+                messageIds_.capacity() * sizeof(std::uint32_t) + dictionaryOrder_.capacity() * sizeof(void*) +
+                dictionary_.size() * kDictionaryNode + dictionaryBytes_ + encoded_.capacity());
+}
+
+int BinaryFileAppender::emergencyFlush() noexcept {
+    file_.emergencyFlush();
+    return -1; // A text marker would not parse as a block
+}
+
+void BinaryFileAppender::prepareFork() {
+    mutex_.lock();
+    try {
+        flushBlock(); // Records written since Logger's flush; the child would inherit them
+        file_.flush();
+    } catch (const std::exception& e) {
+        std::cerr << "BinaryFileAppender error: " << e.what() << std::endl;
+    }
+}
+
+void BinaryFileAppender::afterFork(bool child) {
+    if (child) {
+        ForkHandler::reinitialize(timer_);
+        ForkHandler::reinitialize(timerCv_);
+        file_.reopenAfterFork();
+    }
+    mutex_.unlock();
+    if (child && blockInterval_.count() > 0) {
+        timer_ = std::thread(&BinaryFileAppender::runTimer, this);
+    }
+}
+
+void BinaryFileAppender::runTimer() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stop_) {
+        timerCv_.wait_for(lock, blockInterval_);
+        if (!stop_ && !timestamps_.empty() &&
+            std::chrono::steady_clock::now() - blockSince_ >= blockInterval_) {
+            try {
+                flushBlock();
+                file_.flush(); // A block closed by age is not held back by auto_flush=false
+                trackMemory();
+            } catch (const std::exception& e) {
+                std::cerr << "BinaryFileAppender error: " << e.what() << std::endl;
+            }
+        }
+    }
+}
+
+void BinaryFileAppender::flushBlock() {
+    if (timestamps_.empty()) {
+        return;
+    }
+
+    BinaryLogFormat::BlockHeader header{};
+    header.magic = BinaryLogFormat::kBlockMagic;
+    header.version = BinaryLogFormat::kVersion;
+    header.recordCount = static_cast<std::uint32_t>(timestamps_.size());
+    header.dictionaryCount = static_cast<std::uint32_t>(dictionaryOrder_.size());
+    header.minTimestampNs = *std::min_element(timestamps_.begin(), timestamps_.end());
+    header.maxTimestampNs = *std::max_element(timestamps_.begin(), timestamps_.end());
+    header.minLevel = static_cast<std::uint8_t>(*std::min_element(levels_.begin(), levels_.end()));
+    header.maxLevel = static_cast<std::uint8_t>(*std::max_element(levels_.begin(), levels_.end()));
+
+    // Header placeholder, then the columns
+    encoded_.assign(sizeof(header), '\0');
+    const std::int64_t first = timestamps_.front();
+    encoded_.append(reinterpret_cast<const char*>(&first), sizeof(first));
+    for (size_t i = 1; i < timestamps_.size(); ++i) {
+        BinaryLogFormat::putVarint(encoded_, BinaryLogFormat::zigzag(timestamps_[i] - timestamps_[i - 1]));
+    }
+    encoded_.append(levels_);
+    for (const std::string* message : dictionaryOrder_) {
+        BinaryLogFormat::putVarint(encoded_, message->size());
+        encoded_.append(*message);
+    }
+    for (const std::uint32_t id : messageIds_) {
+        BinaryLogFormat::putVarint(encoded_, id);
+    }
+
+    header.payloadSize = static_cast<std::uint32_t>(encoded_.size() - sizeof(header));
+    header.checksum = BinaryLogFormat::checksum(encoded_.data() + sizeof(header), header.payloadSize);
+    std::memcpy(encoded_.data(), &header, sizeof(header));
+
+    timestamps_.clear();
+    levels_.clear();
+    messageIds_.clear();
+    dictionary_.clear();
+    dictionaryOrder_.clear();
+    dictionaryBytes_ = 0;
+
+    file_.append(encoded_.data(), encoded_.size(), encoded_.size());
+}
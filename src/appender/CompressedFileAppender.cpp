@@ -0,0 +1,151 @@
+#include "opLog/appender/CompressedFileAppender.h"
+#include <climits>
+#include <cstring>
+#include <iostream>
+#include <fcntl.h>
+#include "opLog/Config.h"
+#include "opLog/CrashHandler.h"
+#include "opLog/ForkHandler.h"
+
+namespace {
+    CompressionCodec streamCodec() {
+        const CompressionCodec codec = opLog::Config::getInstance().getStreamCompression();
+        return Compressor::isAvailable(codec) ? codec : CompressionCodec::NONE;
+    }
+}
+
+CompressedFileAppender::CompressedFileAppender()
+    : encoder_(streamCodec() == CompressionCodec::NONE ? nullptr : std::make_unique<FrameEncoder>(streamCodec())),
+      file_(std::string("-log.txt") + Compressor::extension(streamCodec())) {
+    const auto& config = opLog::Config::getInstance();
+    frameSize_ = config.getCompressionFrameSize();
+    frameInterval_ = std::chrono::milliseconds(config.getCompressionFrameIntervalMs());
+    countCompressed_ = config.isMaxFileSizeCompressed();
+    pending_.reserve(frameSize_ + 1024);
+
+    if (frameInterval_.count() > 0) {
+        timer_ = std::thread(&CompressedFileAppender::runTimer, this);
+    }
+}
+
+CompressedFileAppender::~CompressedFileAppender() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    timerCv_.notify_all();
+    if (timer_.joinable()) {
+        timer_.join();
+    }
+
+    try {
+        flushFrame();
+    } catch (const std::exception& e) {
+        std::cerr << "CompressedFileAppender error: " << e.what() << std::endl;
+    }
+}
+
+void CompressedFileAppender::write(const std::string& message) {
+    write(LogRecord{LogLevel::INFO, {}, std::chrono::system_clock::now()}, message);
+}
+
+void CompressedFileAppender::write(const LogRecord& record, const std::string& message) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    const auto timestampNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        record.timestamp.time_since_epoch()).count();
+    if (file_.rolloverDue(timestampNs)) {
+        flushFrame(); // Finish the frame in the file it belongs to
+        file_.roll(timestampNs);
+    }
+
+    if (pending_.empty()) {
+        pendingSince_ = std::chrono::steady_clock::now();
+    }
+    pending_.append(message);
+    pending_.push_back('\n');
+
+    if (pending_.size() >= frameSize_) {
+        flushFrame();
+    }
+    memory_.set(pending_.capacity() + frame_.capacity());
+}
+
+void CompressedFileAppender::flush() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    flushFrame();
+}
+
+int CompressedFileAppender::emergencyFlush() noexcept {
+    file_.emergencyFlush();
+
+    constexpr char extension[] = ".crash";
+    const std::string& path = file_.path();
+    char crashPath[PATH_MAX];
+    if (pending_.empty() || path.empty() || path.size() + sizeof(extension) > sizeof(crashPath)) {
+        return -1;
+    }
+    std::memcpy(crashPath, path.data(), path.size());
+    std::memcpy(crashPath + path.size(), extension, sizeof(extension));
+
+    const int fd = ::open(crashPath, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (fd >= 0) {
+        CrashHandler::writeAll(fd, pending_.data(), pending_.size());
+    }
+    return fd; // Left open for the marker; the process is going down
+}
+
+void CompressedFileAppender::prepareFork() {
+    mutex_.lock();
+    try {
+        flushFrame();
+    } catch (const std::exception& e) {
+        std::cerr << "CompressedFileAppender error: " << e.what() << std::endl;
+    }
+}
+
+void CompressedFileAppender::afterFork(bool child) {
+    if (child) {
+        ForkHandler::reinitialize(timer_);
+        ForkHandler::reinitialize(timerCv_);
+        pending_.clear();
+        file_.reopenAfterFork();
+    }
+    mutex_.unlock();
+    if (child && frameInterval_.count() > 0) {
+        timer_ = std::thread(&CompressedFileAppender::runTimer, this);
+    }
+}
+
+void CompressedFileAppender::flushFrame() {
+    if (pending_.empty()) {
+        return;
+    }
+
+    if (encoder_) {
+        frame_.clear();
+        encoder_->encode(pending_.data(), pending_.size(), frame_);
+        file_.append(frame_.data(), frame_.size(), countCompressed_ ? frame_.size() : pending_.size());
+    } else {
+        file_.append(pending_.data(), pending_.size(), pending_.size());
+    }
+    pending_.clear();
+
+    // A frame is the unit of durability: hand it to the OS right away
+    file_.flush();
+}
+
+void CompressedFileAppender::runTimer() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stop_) {
+        timerCv_.wait_for(lock, frameInterval_);
+        if (!stop_ && !pending_.empty() &&
+            std::chrono::steady_clock::now() - pendingSince_ >= frameInterval_) {
+            try {
+                flushFrame();
+            } catch (const std::exception& e) {
+                std::cerr << "CompressedFileAppender error: " << e.what() << std::endl;
+            }
+        }
+    }
+}
@@ -1,6 +1,180 @@
 #include "opLog/appender/ConsoleAppender.h"
+#include <algorithm>
+#include <cerrno>
+#include <poll.h>
+#include <unistd.h>
+#include "opLog/Config.h"
+#include "opLog/CrashHandler.h"
+#include "opLog/ForkHandler.h"
 
+namespace {
+    constexpr size_t BUFFER_LIMIT = 64 * 1024;
+
+    bool useColors(int fd) {
+        const auto& config = opLog::Config::getInstance();
+        switch (config.getConsoleColors()) {
+            case ConsoleColors::ALWAYS: return true;
+            case ConsoleColors::NEVER: return false;
+            case ConsoleColors::AUTO: break;
+        }
+        return ::isatty(fd) == 1;
+    }
+
+    // Appends `message` without ANSI escape sequences (ESC [ ... final byte)
+    void appendStripped(std::string& buffer, const std::string& message) {
+        size_t start = 0;
+        size_t esc;
+        while ((esc = message.find('\033', start)) != std::string::npos) {
+            buffer.append(message, start, esc - start);
+            size_t end = esc + 1;
+            if (end < message.size() && message[end] == '[') {
+                ++end;
+                while (end < message.size() && (message[end] < 0x40 || message[end] > 0x7e)) {
+                    ++end;
+                }
+            }
+            start = end + 1;
+        }
+        if (start < message.size()) {
+            buffer.append(message, start, std::string::npos);
+        }
+    }
+}
+
+ConsoleAppender::ConsoleAppender()
+    : out_{STDOUT_FILENO, false, {}},
+      err_{STDERR_FILENO, false, {}} {
+    loadSettings();
+}
+
+void ConsoleAppender::loadSettings() {
+    configGeneration_ = opLog::Config::generation();
+    const auto& config = opLog::Config::getInstance();
+    out_.colors = useColors(STDOUT_FILENO);
+    err_.colors = useColors(STDERR_FILENO);
+    splitStderr_ = config.isConsoleSplitStderr();
+    stderrLevel_ = config.getConsoleStderrLevel();
+    autoFlush_ = config.isAutoFlushEnabled();
+    flushInterval_ = std::chrono::milliseconds(std::max(0LL, config.getConsoleFlushIntervalMs()));
+}
+
+ConsoleAppender::~ConsoleAppender() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    timerCv_.notify_all();
+    if (timer_.joinable()) {
+        timer_.join();
+    }
+    flush();
+}
 
 void ConsoleAppender::write(const std::string& message) {
-    std::cout << message << "\n";
+    std::lock_guard<std::mutex> lock(mutex_);
+    append(out_, message);
+}
+
+void ConsoleAppender::write(const LogRecord& record, const std::string& message) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (configGeneration_ != opLog::Config::generation()) {
+        loadSettings();
+    }
+    if (splitStderr_ && record.logLevel >= stderrLevel_) {
+        // Keep the two streams in order when they share a terminal
+        flushStream(out_);
+        append(err_, message);
+        flushStream(err_);
+    } else {
+        append(out_, message);
+    }
+}
+
+void ConsoleAppender::flush() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    flushStream(out_);
+    flushStream(err_);
+    if (MemoryBudget::pressure() != MemoryBudget::Pressure::NORMAL) {
+        for (Stream* stream : {&out_, &err_}) {
+            std::string().swap(stream->buffer);
+            stream->memory.set(0);
+        }
+    }
+}
+
+int ConsoleAppender::emergencyFlush() noexcept {
+    CrashHandler::writeAll(out_.fd, out_.buffer.data(), out_.buffer.size());
+    CrashHandler::writeAll(err_.fd, err_.buffer.data(), err_.buffer.size());
+    return err_.fd;
+}
+
+void ConsoleAppender::prepareFork() {
+    mutex_.lock();
+}
+
+void ConsoleAppender::afterFork(bool child) {
+    if (child) {
+        // Started again by the next record the child holds back
+        ForkHandler::reinitialize(timer_);
+        ForkHandler::reinitialize(timerCv_);
+    }
+    mutex_.unlock();
+}
+
+void ConsoleAppender::append(Stream& stream, const std::string& message) {
+    const bool wasEmpty = out_.buffer.empty() && err_.buffer.empty();
+    if (stream.colors) {
+        stream.buffer.append(message);
+    } else {
+        appendStripped(stream.buffer, message);
+    }
+    stream.buffer.push_back('\n');
+
+    if (autoFlush_ || stream.buffer.size() >= BUFFER_LIMIT) {
+        flushStream(stream);
+    } else if (wasEmpty && flushInterval_.count() > 0) {
+        bufferedSince_ = std::chrono::steady_clock::now();
+        if (!timer_.joinable()) {
+            timer_ = std::thread(&ConsoleAppender::runTimer, this);
+        }
+        timerCv_.notify_one();
+    }
+    stream.memory.set(stream.buffer.capacity());
+}
+
+void ConsoleAppender::runTimer() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stop_) {
+        if ((out_.buffer.empty() && err_.buffer.empty()) || flushInterval_.count() == 0) {
+            timerCv_.wait(lock);
+            continue;
+        }
+        const auto due = bufferedSince_ + flushInterval_;
+        if (std::chrono::steady_clock::now() < due) {
+            timerCv_.wait_until(lock, due);
+            continue;
+        }
+        flushStream(out_);
+        flushStream(err_);
+    }
+}
+
+void ConsoleAppender::flushStream(Stream& stream) {
+    const char* data = stream.buffer.data();
+    size_t remaining = stream.buffer.size();
+    while (remaining > 0) {
+        const ssize_t written = ::write(stream.fd, data, remaining);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN) {
+                pollfd pfd{stream.fd, POLLOUT, 0};
+                ::poll(&pfd, 1, -1);
+                continue;
+            }
+            break; // Console is gone; nothing useful to report it to
+        }
+        data += written;
+        remaining -= static_cast<size_t>(written);
+    }
+    stream.buffer.clear();
 }
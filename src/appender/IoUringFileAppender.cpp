@@ -0,0 +1,382 @@
+#include "opLog/appender/IoUringFileAppender.h"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include "opLog/Config.h"
+#include "opLog/MemoryBudget.h"
+
+namespace {
+    constexpr std::size_t BUFFER_SIZE = 64 * 1024; // One RollingFile buffer
+
+    // No liburing: the three syscalls are all we need
+    int ioUringSetup(unsigned entries, io_uring_params* params) {
+        return static_cast<int>(::syscall(__NR_io_uring_setup, entries, params));
+    }
+
+    int ioUringEnter(int ringFd, unsigned toSubmit, unsigned minComplete, unsigned flags) {
+        return static_cast<int>(::syscall(__NR_io_uring_enter, ringFd, toSubmit, minComplete, flags, nullptr, 0));
+    }
+
+    int ioUringRegister(int ringFd, unsigned opcode, const void* arg, unsigned count) {
+        return static_cast<int>(::syscall(__NR_io_uring_register, ringFd, opcode, arg, count));
+    }
+
+    // pwrite(2) all of it; signal-safe. Returns 0 or an errno value.
+    int writeAt(int fd, const char* data, std::size_t size, off_t offset) noexcept {
+        while (size > 0) {
+            const ssize_t written = ::pwrite(fd, data, size, offset);
+            if (written < 0) {
+                if (errno == EINTR) continue;
+                return errno;
+            }
+            data += written;
+            size -= static_cast<std::size_t>(written);
+            offset += written;
+        }
+        return 0;
+    }
+}
+
+// The ring and its buffer pool. Only one thread uses it at a time (Logger
+// serializes the appender), so the submission side needs no locking; the
+// kernel is the only other party, synchronized through the ring indices.
+class IoUringOutput final : public RollingFile::Output {
+private:
+    struct Buffer {
+        char* data{nullptr};
+        int fd{-1};
+        off_t offset{0};
+        std::size_t size{0};
+        std::size_t done{0}; // Written so far; a short write is resubmitted
+        bool busy{false};
+    };
+
+    std::vector<char> memory_;
+    MemoryBudget::Account charged_{memory_.size()};
+    std::vector<Buffer> buffers_;
+    std::vector<unsigned> free_;
+    std::size_t inFlight_{0};
+    int error_{0}; // First failed completion, thrown by the next call
+    int setupError_{0};
+
+    int ringFd_{-1};
+    bool fixed_{false}; // Buffers registered with the ring
+    void* sqMap_{MAP_FAILED};
+    std::size_t sqMapSize_{0};
+    void* cqMap_{MAP_FAILED};
+    std::size_t cqMapSize_{0};
+    io_uring_sqe* sqes_{static_cast<io_uring_sqe*>(MAP_FAILED)};
+    std::size_t sqesSize_{0};
+    unsigned* sqTail_{nullptr};
+    unsigned* sqMask_{nullptr};
+    unsigned* sqArray_{nullptr};
+    unsigned* cqHead_{nullptr};
+    unsigned* cqTail_{nullptr};
+    unsigned* cqMask_{nullptr};
+    io_uring_cqe* cqes_{nullptr};
+
+    bool setup() {
+        io_uring_params params{};
+        ringFd_ = ioUringSetup(static_cast<unsigned>(buffers_.size()), &params);
+        if (ringFd_ < 0) {
+            setupError_ = errno;
+            return false;
+        }
+
+        sqMapSize_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cqMapSize_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        const bool singleMap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (singleMap) {
+            sqMapSize_ = cqMapSize_ = std::max(sqMapSize_, cqMapSize_);
+        }
+        sqMap_ = ::mmap(nullptr, sqMapSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd_,
+                        IORING_OFF_SQ_RING);
+        if (sqMap_ == MAP_FAILED) {
+            teardown();
+            return false;
+        }
+        if (singleMap) {
+            cqMap_ = sqMap_;
+        } else {
+            cqMap_ = ::mmap(nullptr, cqMapSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd_,
+                            IORING_OFF_CQ_RING);
+            if (cqMap_ == MAP_FAILED) {
+                teardown();
+                return false;
+            }
+        }
+        sqesSize_ = params.sq_entries * sizeof(io_uring_sqe);
+        sqes_ = static_cast<io_uring_sqe*>(::mmap(nullptr, sqesSize_, PROT_READ | PROT_WRITE,
+                                                  MAP_SHARED | MAP_POPULATE, ringFd_, IORING_OFF_SQES));
+        if (sqes_ == MAP_FAILED) {
+            teardown();
+            return false;
+        }
+
+        auto* sq = static_cast<char*>(sqMap_);
+        auto* cq = static_cast<char*>(cqMap_);
+        sqTail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+        sqMask_ = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        sqArray_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+        cqHead_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+        cqTail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+        cqMask_ = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+        cqes_ = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+
+        // Registered buffers save pinning the pages on every write; without
+        // them (RLIMIT_MEMLOCK) plain IORING_OP_WRITE does the same job
+        std::vector<iovec> iovecs;
+        for (const Buffer& buffer : buffers_) {
+            iovecs.push_back({buffer.data, BUFFER_SIZE});
+        }
+        fixed_ = ioUringRegister(ringFd_, IORING_REGISTER_BUFFERS, iovecs.data(),
+                                 static_cast<unsigned>(iovecs.size())) == 0;
+        return true;
+    }
+
+    void teardown() {
+        if (ringFd_ >= 0 && sqes_ == MAP_FAILED) {
+            setupError_ = errno; // A mapping failed
+        }
+        if (sqes_ != MAP_FAILED) ::munmap(sqes_, sqesSize_);
+        if (cqMap_ != MAP_FAILED && cqMap_ != sqMap_) ::munmap(cqMap_, cqMapSize_);
+        if (sqMap_ != MAP_FAILED) ::munmap(sqMap_, sqMapSize_);
+        if (ringFd_ >= 0) ::close(ringFd_);
+        sqes_ = static_cast<io_uring_sqe*>(MAP_FAILED);
+        cqMap_ = sqMap_ = MAP_FAILED;
+        ringFd_ = -1;
+        fixed_ = false;
+    }
+
+    void submit(unsigned index) {
+        Buffer& buffer = buffers_[index];
+        const unsigned tail = *sqTail_; // We are the only producer
+        const unsigned slot = tail & *sqMask_;
+        io_uring_sqe& sqe = sqes_[slot];
+        std::memset(&sqe, 0, sizeof(sqe));
+        sqe.opcode = fixed_ ? IORING_OP_WRITE_FIXED : IORING_OP_WRITE;
+        sqe.fd = buffer.fd;
+        sqe.addr = reinterpret_cast<std::uint64_t>(buffer.data + buffer.done);
+        sqe.len = static_cast<std::uint32_t>(buffer.size - buffer.done);
+        sqe.off = static_cast<std::uint64_t>(buffer.offset) + buffer.done;
+        sqe.buf_index = fixed_ ? static_cast<std::uint16_t>(index) : 0;
+        sqe.user_data = index;
+        sqArray_[slot] = slot;
+        std::atomic_ref<unsigned>(*sqTail_).store(tail + 1, std::memory_order_release);
+
+        // The submission ring has a slot per buffer, so it never fills up
+        while (ioUringEnter(ringFd_, 1, 0, 0) < 0) {
+            if (errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+                throw std::runtime_error(std::string("io_uring_enter failed: ") + std::strerror(errno));
+            }
+            reap();
+        }
+    }
+
+    void release(unsigned index) {
+        buffers_[index].busy = false;
+        free_.push_back(index);
+        --inFlight_;
+    }
+
+    void complete(unsigned index, int result) {
+        Buffer& buffer = buffers_[index];
+        if (result == -EINTR || result == -EAGAIN) {
+            submit(index);
+            return;
+        }
+        if (result <= 0) {
+            if (error_ == 0) error_ = result < 0 ? -result : EIO;
+            release(index);
+            return;
+        }
+        buffer.done += static_cast<std::size_t>(result);
+        if (buffer.done < buffer.size) {
+            submit(index); // Short write: the rest, at the right offset
+            return;
+        }
+        release(index);
+    }
+
+    // Handles every completion already posted; never blocks
+    void reap() {
+        unsigned head = *cqHead_;
+        while (head != std::atomic_ref<unsigned>(*cqTail_).load(std::memory_order_acquire)) {
+            const io_uring_cqe cqe = cqes_[head & *cqMask_];
+            ++head;
+            std::atomic_ref<unsigned>(*cqHead_).store(head, std::memory_order_release);
+            complete(static_cast<unsigned>(cqe.user_data), cqe.res);
+        }
+    }
+
+    void waitForCompletion() {
+        if (ioUringEnter(ringFd_, 0, 1, IORING_ENTER_GETEVENTS) < 0 && errno != EINTR) {
+            throw std::runtime_error(std::string("io_uring_enter failed: ") + std::strerror(errno));
+        }
+        reap();
+    }
+
+    void throwIfFailed() {
+        if (error_ != 0) {
+            const int error = error_;
+            error_ = 0;
+            throw std::runtime_error(std::string("Error writing to file: ") + std::strerror(error));
+        }
+    }
+
+    void resetBuffers() {
+        free_.clear();
+        for (unsigned i = static_cast<unsigned>(buffers_.size()); i-- > 0;) {
+            buffers_[i].busy = false;
+            free_.push_back(i);
+        }
+        inFlight_ = 0;
+    }
+
+public:
+    explicit IoUringOutput(std::size_t buffers) : memory_(std::max<std::size_t>(buffers, 1) * BUFFER_SIZE) {
+        buffers_.resize(std::max<std::size_t>(buffers, 1));
+        for (std::size_t i = 0; i < buffers_.size(); ++i) {
+            buffers_[i].data = memory_.data() + i * BUFFER_SIZE;
+        }
+        resetBuffers();
+        setup();
+    }
+
+    ~IoUringOutput() override {
+        try {
+            while (inFlight_ > 0) waitForCompletion();
+        } catch (...) {
+            // The ring is going away either way
+        }
+        teardown();
+    }
+
+    IoUringOutput(const IoUringOutput&) = delete;
+    IoUringOutput& operator=(const IoUringOutput&) = delete;
+
+    bool ready() const { return ringFd_ >= 0; }
+    int setupError() const { return setupError_; }
+
+    void write(int fd, const char* data, std::size_t size, off_t offset) override {
+        throwIfFailed();
+        if (!ready()) {
+            if (const int error = writeAt(fd, data, size, offset)) {
+                throw std::runtime_error(std::string("Error writing to file: ") + std::strerror(error));
+            }
+            return;
+        }
+
+        reap();
+        while (size > 0) {
+            while (free_.empty()) {
+                waitForCompletion(); // Every buffer in flight: the disk is behind
+            }
+            const unsigned index = free_.back();
+            free_.pop_back();
+            Buffer& buffer = buffers_[index];
+            const std::size_t chunk = std::min(size, BUFFER_SIZE);
+            std::memcpy(buffer.data, data, chunk);
+            buffer.fd = fd;
+            buffer.offset = offset;
+            buffer.size = chunk;
+            buffer.done = 0;
+            buffer.busy = true;
+            ++inFlight_;
+            submit(index);
+
+            data += chunk;
+            size -= chunk;
+            offset += static_cast<off_t>(chunk);
+        }
+    }
+
+    // One file is written at a time, so this waits for everything
+    void finish(int fd) override {
+        (void)fd;
+        while (inFlight_ > 0) {
+            waitForCompletion();
+        }
+        throwIfFailed();
+    }
+
+    void emergencyFlush() noexcept override {
+        for (const Buffer& buffer : buffers_) {
+            if (buffer.busy) {
+                writeAt(buffer.fd, buffer.data, buffer.size, buffer.offset);
+            }
+        }
+    }
+
+    // In a forked child: the ring's memory is shared with the parent, so
+    // drop our mapping of it and set up a new one
+    void reinitAfterFork() {
+        teardown();
+        resetBuffers(); // The parent flushed before forking
+        error_ = 0;
+        setup();
+    }
+};
+
+IoUringFileAppender::IoUringFileAppender()
+    : output_(std::make_unique<IoUringOutput>(opLog::Config::getInstance().getIoUringBuffers())),
+      file_("-log.txt", output_.get()) {
+    if (!output_->ready()) {
+        std::cerr << "Warning: io_uring unavailable (" << std::strerror(output_->setupError())
+                  << "), using pwrite" << std::endl;
+    }
+}
+
+IoUringFileAppender::~IoUringFileAppender() = default;
+
+void IoUringFileAppender::write(const std::string& message) {
+    write(LogRecord{LogLevel::INFO, {}, std::chrono::system_clock::now()}, message);
+}
+
+void IoUringFileAppender::write(const LogRecord& record, const std::string& message) {
+    try {
+        const auto timestampNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            record.timestamp.time_since_epoch()).count();
+        if (record.payload) {
+            file_.write(timestampNs, message, record.payload);
+        } else {
+            file_.write(timestampNs, message);
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "IoUringFileAppender error: " << e.what() << std::endl;
+        throw;
+    }
+}
+
+void IoUringFileAppender::flush() {
+    file_.flush();
+}
+
+int IoUringFileAppender::emergencyFlush() noexcept {
+    return file_.emergencyFlush();
+}
+
+void IoUringFileAppender::prepareFork() {
+    file_.flush(); // Nothing in flight when the ring is duplicated
+}
+
+void IoUringFileAppender::afterFork(bool child) {
+    if (child) {
+        file_.reopenAfterFork();
+        output_->reinitAfterFork();
+    }
+}
+
+bool IoUringFileAppender::usingIoUring() const {
+    return output_->ready();
+}
@@ -0,0 +1,370 @@
+#include "opLog/appender/RollingFile.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include "opLog/Config.h"
+#include "opLog/CrashHandler.h"
+#include "opLog/appender/RotationWorker.h"
+#include "opLog/appender/TimeIndex.h"
+#include "opLog/formatter/MessageSanitizer.h"
+
+namespace {
+    constexpr long long NANOS_PER_SECOND = 1000000000LL;
+    constexpr long long SECONDS_PER_HOUR = 3600;
+    constexpr long long SECONDS_PER_DAY = 86400;
+
+    // Local midnight of the day `offsetDays` after the day containing `t`
+    std::time_t localMidnight(std::time_t t, int offsetDays = 0) {
+        std::tm local{};
+        localtime_r(&t, &local);
+        local.tm_hour = 0;
+        local.tm_min = 0;
+        local.tm_sec = 0;
+        local.tm_mday += offsetDays;
+        local.tm_isdst = -1;
+        return std::mktime(&local);
+    }
+
+    // Period names are as coarse as the interval allows
+    const char* periodFormat(long long interval) {
+        if (interval == 0 || interval % SECONDS_PER_DAY == 0) return "%Y-%m-%d";
+        if (interval % SECONDS_PER_HOUR == 0) return "%Y-%m-%d-%H";
+        if (interval % 60 == 0) return "%Y-%m-%d-%H%M";
+        return "%Y-%m-%d-%H%M%S";
+    }
+
+    // For settingsChanged(). Never destroyed: files owned by static loggers
+    // are closed after this file's statics would be
+    std::mutex filesMutex;
+    std::vector<RollingFile*>& files = *new std::vector<RollingFile*>;
+}
+
+RollingFile::RollingFile(std::string suffix, Output* output) : suffix_(std::move(suffix)), output_(output) {
+    {
+        std::lock_guard<std::mutex> lock(filesMutex);
+        files.push_back(this);
+    }
+    loadSettings();
+    RotationWorker::getInstance().recover(directory_);
+}
+
+RollingFile::~RollingFile() {
+    {
+        std::lock_guard<std::mutex> lock(filesMutex);
+        files.erase(std::find(files.begin(), files.end(), this));
+    }
+    try {
+        close();
+    } catch (...) {
+        // Nothing sensible left to do with a write error during teardown
+    }
+}
+
+void RollingFile::loadSettings() {
+    configGeneration_ = opLog::Config::generation();
+    const auto& config = opLog::Config::getInstance();
+    directory_ = config.getLogDirectory();
+    maxFileSize_ = config.getMaxFileSize();
+    interval_ = std::max(0LL, config.getRotationInterval());
+    autoFlush_ = config.isAutoFlushEnabled();
+    sanitize_ = config.isSanitizeMessagesEnabled();
+}
+
+void RollingFile::write(long long timestampNs, const std::string& message) {
+    if (rolloverDue(timestampNs)) {
+        roll(timestampNs);
+    }
+
+    buffer_.append(message);
+    buffer_.push_back('\n');
+    size_ += message.size() + 1;
+
+    if (autoFlush_ || buffer_.size() >= kBufferLimit) {
+        flushBuffer();
+    }
+    if (size_ >= maxFileSize_) {
+        nextRolloverNs_.store(kRollNow, std::memory_order_relaxed); // Size rotation before the next record
+    }
+    trackMemory();
+}
+
+void RollingFile::write(long long timestampNs, const std::string& message, const Payload& payload) {
+    if (rolloverDue(timestampNs)) {
+        roll(timestampNs);
+    }
+
+    // The formatter escaped the message; a raw payload is escaped here
+    const std::string_view raw(reinterpret_cast<const char*>(payload.data()), payload.size());
+    const bool escape = sanitize_ && payload.encoding() == Payload::Encoding::RAW && !MessageSanitizer::isClean(raw);
+    if (escape) {
+        rendered_.clear();
+        MessageSanitizer::appendEscaped(rendered_, raw);
+    }
+
+    const std::string tail = payload.note() + '\n';
+    const std::size_t payloadSize = escape ? rendered_.size() : payload.renderedSize();
+    buffer_.append(message);
+    buffer_.push_back(' ');
+    size_ += message.size() + 1 + payloadSize + tail.size();
+
+    if (output_ || payloadSize < kGatherLimit) {
+        // An Output copies what it is given anyway
+        if (escape) {
+            buffer_.append(rendered_);
+        } else {
+            const std::size_t start = buffer_.size();
+            buffer_.resize(start + payloadSize);
+            payload.render(buffer_.data() + start);
+        }
+        buffer_.append(tail);
+        if (autoFlush_ || buffer_.size() >= kBufferLimit) {
+            flushBuffer();
+        }
+    } else if (escape) {
+        writeGathered(rendered_.data(), payloadSize, tail);
+    } else if (payload.encoding() == Payload::Encoding::RAW) {
+        writeGathered(raw.data(), payloadSize, tail);
+    } else {
+        rendered_.resize(payloadSize);
+        payload.render(rendered_.data());
+        writeGathered(rendered_.data(), payloadSize, tail);
+    }
+
+    if (size_ >= maxFileSize_) {
+        nextRolloverNs_.store(kRollNow, std::memory_order_relaxed);
+    }
+    trackMemory();
+}
+
+void RollingFile::append(const char* data, std::size_t size, std::size_t countedBytes) {
+    if (fd_ < 0) {
+        roll(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count());
+    }
+
+    buffer_.append(data, size);
+    size_ += countedBytes;
+
+    if (autoFlush_ || buffer_.size() >= kBufferLimit) {
+        flushBuffer();
+    }
+    if (size_ >= maxFileSize_) {
+        nextRolloverNs_.store(kRollNow, std::memory_order_relaxed);
+    }
+    trackMemory();
+}
+
+void RollingFile::flush() {
+    flushBuffer();
+    if (output_ && fd_ >= 0) {
+        output_->finish(fd_);
+    }
+    if (MemoryBudget::pressure() != MemoryBudget::Pressure::NORMAL) {
+        std::string().swap(buffer_);
+        std::string().swap(rendered_);
+        trackMemory();
+    }
+}
+
+void RollingFile::roll(long long timestampNs) {
+    const long long interval = interval_;
+    const std::string directory = directory_;
+    loadSettings();
+    if (interval_ != interval || directory_ != directory) {
+        periodEndNs_ = kRollNow; // Reloaded config: the file name follows the new settings now
+    }
+
+    if (timestampNs >= periodEndNs_) {
+        startPeriod(timestampNs);
+    }
+
+    if (fd_ >= 0 && size_ >= maxFileSize_) {
+        // Only the rename happens here; backups are shifted by the worker
+        const auto seq = static_cast<std::uint64_t>(
+            std::chrono::system_clock::now().time_since_epoch().count());
+        const std::string pending = RotationWorker::pendingPath(path_, seq);
+        const std::string current = path_;
+
+        close();
+        std::filesystem::rename(current, pending);
+        std::error_code ec; // The time index sidecar travels with its log, if there is one
+        std::filesystem::rename(current + TimeIndex::kSuffix, pending + TimeIndex::kSuffix, ec);
+        open(current);
+        RotationWorker::getInstance().submit(pending, current);
+    }
+
+    // A change that came in while the settings were being read is seen on
+    // the next record
+    std::lock_guard<std::mutex> lock(filesMutex);
+    nextRolloverNs_.store(configGeneration_ == opLog::Config::generation() ? periodEndNs_ : kRollNow,
+                          std::memory_order_relaxed);
+}
+
+void RollingFile::settingsChanged() {
+    std::lock_guard<std::mutex> lock(filesMutex);
+    for (RollingFile* file : files) {
+        file->nextRolloverNs_.store(kRollNow, std::memory_order_relaxed);
+    }
+}
+
+void RollingFile::prepareFork() {
+    filesMutex.lock();
+}
+
+void RollingFile::afterFork() {
+    filesMutex.unlock();
+}
+
+void RollingFile::startPeriod(long long timestampNs) {
+    const auto seconds = static_cast<std::time_t>(timestampNs / NANOS_PER_SECOND);
+    const std::time_t midnight = localMidnight(seconds);
+
+    std::time_t periodStart = midnight;
+    long long periodEnd = LLONG_MAX / NANOS_PER_SECOND;
+    if (interval_ > 0 && interval_ % SECONDS_PER_DAY == 0) {
+        periodEnd = localMidnight(seconds, static_cast<int>(interval_ / SECONDS_PER_DAY));
+    } else if (interval_ > SECONDS_PER_DAY) {
+        periodEnd = midnight + interval_;
+    } else if (interval_ > 0) {
+        // Sub-day intervals are aligned to local midnight and never straddle it
+        periodStart = midnight + ((seconds - midnight) / interval_) * interval_;
+        periodEnd = std::min<long long>(periodStart + interval_, localMidnight(seconds, 1));
+    }
+    periodEndNs_ = periodEnd * NANOS_PER_SECOND;
+
+    std::tm local{};
+    localtime_r(&periodStart, &local);
+    char name[64];
+    std::strftime(name, sizeof(name), periodFormat(interval_), &local);
+
+    std::string suffix = suffix_;
+    if (!pidTag_.empty()) {
+        suffix.insert(std::min(suffix.find('.'), suffix.size()), pidTag_); // -log.p4242.txt
+    }
+    const std::string path = (std::filesystem::path(directory_) / (name + suffix)).string();
+    if (path != path_) {
+        close();
+        open(path);
+    }
+}
+
+void RollingFile::open(const std::string& path) {
+    const std::filesystem::path parent = std::filesystem::path(path).parent_path();
+    if (!parent.empty() && !std::filesystem::exists(parent)) {
+        std::filesystem::create_directories(parent);
+    }
+
+    fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | O_CLOEXEC | (output_ ? 0 : O_APPEND), 0644);
+    if (fd_ < 0) {
+        throw std::runtime_error("Error opening output file: " + path + ": " + std::strerror(errno));
+    }
+
+    struct stat st{};
+    size_ = ::fstat(fd_, &st) == 0 ? static_cast<std::size_t>(st.st_size) : 0;
+    offset_ = static_cast<off_t>(size_);
+    path_ = path;
+    ++generation_;
+}
+
+void RollingFile::close() {
+    if (fd_ < 0) {
+        return;
+    }
+    flushBuffer();
+    if (output_) {
+        output_->finish(fd_); // Complete before the file is renamed or rotated away
+    }
+    ::close(fd_);
+    fd_ = -1;
+}
+
+int RollingFile::emergencyFlush() noexcept {
+    if (fd_ < 0) {
+        return -1;
+    }
+    // The buffer is left as is: the crashing thread may be in the middle of it
+    if (output_) {
+        output_->emergencyFlush();
+        ::lseek(fd_, offset_, SEEK_SET); // The marker goes after our bytes
+    }
+    CrashHandler::writeAll(fd_, buffer_.data(), buffer_.size());
+    return fd_;
+}
+
+void RollingFile::reopenAfterFork() {
+    buffer_.clear();
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+    if (opLog::Config::getInstance().isForkPidSuffix()) {
+        pidTag_ = ".p" + std::to_string(::getpid());
+    }
+    path_.clear();
+    periodEndNs_ = kRollNow;
+    nextRolloverNs_.store(kRollNow, std::memory_order_relaxed);
+}
+
+void RollingFile::writeGathered(const char* payload, std::size_t payloadSize, const std::string& tail) {
+    iovec parts[3] = {
+        {buffer_.data(), buffer_.size()},
+        {const_cast<char*>(payload), payloadSize},
+        {const_cast<char*>(tail.data()), tail.size()},
+    };
+    iovec* next = parts;
+    int count = 3;
+    while (count > 0 && fd_ >= 0) {
+        ssize_t written = ::writev(fd_, next, count);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            buffer_.clear();
+            throw std::runtime_error("Error writing to file: " + path_ + ": " + std::strerror(errno));
+        }
+        // Skip what went out, resuming a short write in the middle of a part
+        while (count > 0 && static_cast<std::size_t>(written) >= next->iov_len) {
+            written -= static_cast<ssize_t>(next->iov_len);
+            ++next;
+            --count;
+        }
+        if (count > 0) {
+            next->iov_base = static_cast<char*>(next->iov_base) + written;
+            next->iov_len -= static_cast<std::size_t>(written);
+        }
+    }
+    buffer_.clear();
+}
+
+void RollingFile::flushBuffer() {
+    if (output_) {
+        if (!buffer_.empty() && fd_ >= 0) {
+            output_->write(fd_, buffer_.data(), buffer_.size(), offset_);
+            offset_ += static_cast<off_t>(buffer_.size());
+        }
+        buffer_.clear();
+        return;
+    }
+
+    const char* data = buffer_.data();
+    size_t remaining = buffer_.size();
+    while (remaining > 0 && fd_ >= 0) {
+        const ssize_t written = ::write(fd_, data, remaining);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            buffer_.clear();
+            throw std::runtime_error("Error writing to file: " + path_ + ": " + std::strerror(errno));
+        }
+        data += written;
+        remaining -= static_cast<size_t>(written);
+    }
+    buffer_.clear();
+}
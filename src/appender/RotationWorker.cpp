@@ -0,0 +1,301 @@
+#include "opLog/appender/RotationWorker.h"
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+#include <iostream>
+#include <vector>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include "opLog/Config.h"
+#include "opLog/ForkHandler.h"
+#include "opLog/appender/TimeIndex.h"
+#include "opLog/compression/Compressor.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+    const std::string PENDING_MARKER = ".pending-";
+    const std::string TEMP_SUFFIX = ".tmp";
+    // A backup generation may exist in any of these forms
+    const CompressionCodec BACKUP_CODECS[] = {CompressionCodec::NONE, CompressionCodec::GZIP, CompressionCodec::ZSTD};
+
+    std::string backupPath(const fs::path& basePath, int index, CompressionCodec codec = CompressionCodec::NONE) {
+        fs::path backup = basePath.parent_path();
+        backup /= basePath.stem().string() + "." + std::to_string(index) + basePath.extension().string()
+                  + Compressor::extension(codec);
+        return backup.string();
+    }
+
+    // 2024-01-15-log.3.txt -> 2024-01-15-log.txt, or empty if not a numbered backup
+    std::string baseOfBackup(const fs::path& path) {
+        const fs::path stem = path.stem();
+        const std::string index = stem.extension().string();
+        if (index.size() < 2 || !std::all_of(index.begin() + 1, index.end(), [](unsigned char c) { return std::isdigit(c); })) {
+            return "";
+        }
+        return (path.parent_path() / (stem.stem().string() + path.extension().string())).string();
+    }
+
+    // True for the temp compressBackups() writes a backup to:
+    // 2024-01-15-log.3.txt.gz.tmp next to its intact 2024-01-15-log.3.txt
+    bool isCompressionTemp(const fs::path& path) {
+        const std::string name = path.filename().string();
+        for (const CompressionCodec codec : {CompressionCodec::GZIP, CompressionCodec::ZSTD}) {
+            const std::string suffix = Compressor::extension(codec) + TEMP_SUFFIX;
+            if (name.size() <= suffix.size() ||
+                name.compare(name.size() - suffix.size(), suffix.size(), suffix) != 0) {
+                continue;
+            }
+            const fs::path original = path.parent_path() / name.substr(0, name.size() - suffix.size());
+            std::error_code ec;
+            return !baseOfBackup(original).empty() && fs::is_regular_file(original, ec);
+        }
+        return false;
+    }
+}
+
+RotationWorker& RotationWorker::getInstance() {
+    static RotationWorker worker;
+    return worker;
+}
+
+RotationWorker::~RotationWorker() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    workCv_.notify_all();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+void RotationWorker::prepareFork() {
+    mutex_.lock();
+}
+
+void RotationWorker::afterFork(bool child) {
+    if (child) {
+        ForkHandler::reinitialize(thread_);
+        ForkHandler::reinitialize(workCv_);
+        ForkHandler::reinitialize(idleCv_);
+        queue_.clear();
+        queued_.clear();
+        busy_ = false;
+    }
+    mutex_.unlock();
+}
+
+std::string RotationWorker::pendingPath(const std::string& basePath, std::uint64_t seq) {
+    const fs::path base(basePath);
+    fs::path pending = base.parent_path();
+    pending /= base.stem().string() + PENDING_MARKER + std::to_string(seq) + base.extension().string();
+    return pending.string();
+}
+
+void RotationWorker::submit(const std::string& pendingPath, const std::string& basePath) {
+    submit(Job{pendingPath, basePath});
+}
+
+void RotationWorker::submit(Job job) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        const std::string key = job.pendingPath.empty() ? "compress:" + job.basePath : job.pendingPath;
+        if (!queued_.insert(key).second) {
+            return; // Already queued
+        }
+        queue_.push_back(std::move(job));
+        if (!thread_.joinable()) {
+            thread_ = std::thread(&RotationWorker::run, this);
+        }
+    }
+    workCv_.notify_one();
+}
+
+void RotationWorker::recover(const std::string& directory) {
+    std::error_code ec;
+    if (!fs::is_directory(directory, ec)) {
+        return;
+    }
+    {
+        // Only the first appender in a directory scans it; later ones would
+        // race with rotations this process already has in flight
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!recovered_.insert(fs::absolute(directory, ec).string()).second) {
+            return;
+        }
+    }
+
+    const CompressionCodec codec = opLog::Config::getInstance().getCompressRotated();
+
+    // Leftovers from a crash: <stem>.pending-<seq><ext>, replayed oldest first
+    std::vector<std::pair<std::uint64_t, Job>> leftovers;
+    std::set<std::string> uncompressed;
+    for (const auto& entry : fs::directory_iterator(directory, ec)) {
+        if (!entry.is_regular_file(ec)) {
+            continue;
+        }
+
+        const std::string name = entry.path().filename().string();
+
+        // Partial output of an interrupted compression; the original is intact.
+        // Other .tmp files in the directory are not ours to delete.
+        if (isCompressionTemp(entry.path())) {
+            fs::remove(entry.path(), ec);
+            continue;
+        }
+
+        // Time index sidecars move together with their log
+        if (fs::path(name).extension() == TimeIndex::kSuffix) {
+            continue;
+        }
+
+        const size_t marker = name.find(PENDING_MARKER);
+        if (marker == std::string::npos) {
+            if (codec != CompressionCodec::NONE) {
+                const std::string base = baseOfBackup(entry.path());
+                if (!base.empty()) {
+                    uncompressed.insert(base);
+                }
+            }
+            continue;
+        }
+
+        const size_t seqStart = marker + PENDING_MARKER.size();
+        const size_t seqEnd = name.find('.', seqStart);
+        try {
+            const std::uint64_t seq = std::stoull(name.substr(seqStart, seqEnd - seqStart));
+            const std::string extension = seqEnd == std::string::npos ? "" : name.substr(seqEnd);
+            const fs::path base = entry.path().parent_path() / (name.substr(0, marker) + extension);
+            leftovers.push_back({seq, Job{entry.path().string(), base.string()}});
+        } catch (const std::exception&) {
+            // Not one of ours
+        }
+    }
+
+    std::sort(leftovers.begin(), leftovers.end(),
+              [](const auto& a, const auto& b) { return a.first < b.first; });
+    for (auto& [seq, job] : leftovers) {
+        submit(std::move(job));
+    }
+    for (const auto& base : uncompressed) {
+        submit(Job{"", base});
+    }
+}
+
+void RotationWorker::drain() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    idleCv_.wait(lock, [this] { return queue_.empty() && !busy_; });
+}
+
+void RotationWorker::run() {
+    // Housekeeping must not compete with the threads producing logs
+    setpriority(PRIO_PROCESS, static_cast<id_t>(::syscall(SYS_gettid)), 19);
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        workCv_.wait(lock, [this] { return stop_ || !queue_.empty(); });
+        if (queue_.empty()) {
+            break; // Stopping with nothing left to do
+        }
+
+        const Job job = std::move(queue_.front());
+        queue_.pop_front();
+        busy_ = true;
+        lock.unlock();
+
+        process(job);
+
+        lock.lock();
+        queued_.erase(job.pendingPath.empty() ? "compress:" + job.basePath : job.pendingPath);
+        busy_ = false;
+        if (queue_.empty()) {
+            idleCv_.notify_all();
+        }
+    }
+}
+
+void RotationWorker::process(const Job& job) {
+    const auto& config = opLog::Config::getInstance();
+    const int maxBackups = config.getMaxBackupFiles();
+    const fs::path base(job.basePath);
+
+    try {
+        if (!job.pendingPath.empty()) {
+            if (maxBackups <= 0) {
+                fs::remove(job.pendingPath);
+                return;
+            }
+
+            // ---- Remove oldest backup, compressed or not ----
+            for (const CompressionCodec codec : BACKUP_CODECS) {
+                fs::remove(backupPath(base, maxBackups, codec));
+            }
+            fs::remove(backupPath(base, maxBackups) + TimeIndex::kSuffix);
+
+            // ---- Shift backup files ----
+            for (int i = maxBackups - 1; i >= 1; --i) {
+                for (const CompressionCodec codec : BACKUP_CODECS) {
+                    const std::string current = backupPath(base, i, codec);
+                    if (fs::exists(current)) {
+                        fs::rename(current, backupPath(base, i + 1, codec));
+                    }
+                }
+                const std::string index = backupPath(base, i) + TimeIndex::kSuffix;
+                if (fs::exists(index)) {
+                    fs::rename(index, backupPath(base, i + 1) + TimeIndex::kSuffix);
+                }
+            }
+
+            // ---- Move rotated file to .1 ----
+            fs::rename(job.pendingPath, backupPath(base, 1));
+            const std::string pendingIndex = job.pendingPath + TimeIndex::kSuffix;
+            if (fs::exists(pendingIndex)) {
+                fs::rename(pendingIndex, backupPath(base, 1) + TimeIndex::kSuffix);
+            }
+        }
+
+        if (config.getCompressRotated() != CompressionCodec::NONE) {
+            compressBackups(job.basePath, maxBackups);
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "RotationWorker error: " << e.what() << std::endl;
+    }
+}
+
+void RotationWorker::compressBackups(const std::string& basePath, int maxBackups) {
+    const CompressionCodec codec = opLog::Config::getInstance().getCompressRotated();
+    if (!Compressor::isAvailable(codec)) {
+        return;
+    }
+
+    const fs::path base(basePath);
+    const std::string extension = base.extension().string();
+    if (extension == Compressor::extension(CompressionCodec::GZIP) ||
+        extension == Compressor::extension(CompressionCodec::ZSTD)) {
+        return; // Written compressed already
+    }
+
+    for (int i = 1; i <= maxBackups; ++i) {
+        const std::string original = backupPath(base, i);
+        if (!fs::exists(original)) {
+            continue;
+        }
+
+        // Write to a temp file and rename, so a crash leaves either the
+        // original alone or the original plus a partial .tmp
+        const std::string compressed = backupPath(base, i, codec);
+        const std::string temp = compressed + TEMP_SUFFIX;
+        try {
+            Compressor::compressFile(original, temp, codec);
+            fs::rename(temp, compressed);
+            fs::remove(original);
+            fs::remove(original + TimeIndex::kSuffix); // Offsets mean nothing once compressed
+        } catch (const std::exception& e) {
+            std::error_code ec;
+            fs::remove(temp, ec);
+            std::cerr << "RotationWorker: cannot compress " << original << ": " << e.what() << std::endl;
+        }
+    }
+}
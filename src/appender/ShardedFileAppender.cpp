@@ -0,0 +1,123 @@
+#include "opLog/appender/ShardedFileAppender.h"
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <csignal>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace {
+    std::atomic<std::uint64_t> nextAppenderId{1};
+
+    // Last shard used by this thread; a miss falls back to the locked map
+    struct ShardCache {
+        std::uint64_t owner{0};
+        void* shard{nullptr};
+    };
+    thread_local ShardCache shardCache;
+
+    bool threadExited(long tid) {
+        return ::syscall(SYS_tgkill, ::getpid(), tid, 0) != 0 && errno == ESRCH;
+    }
+}
+
+ShardedFileAppender::ShardedFileAppender() : id_(nextAppenderId.fetch_add(1)) {}
+
+ShardedFileAppender::Shard& ShardedFileAppender::currentShard() {
+    if (shardCache.owner == id_) {
+        return *static_cast<Shard*>(shardCache.shard);
+    }
+
+    const long tid = ::syscall(SYS_gettid);
+    std::lock_guard<std::mutex> lock(shardsMutex_);
+    auto& shard = shards_[tid];
+    if (!shard) {
+        closeExited();
+        shard = std::make_unique<Shard>("-log.t" + std::to_string(tid) + ".txt");
+    }
+    shardCache = {id_, shard.get()};
+    return *shard;
+}
+
+void ShardedFileAppender::write(const std::string& message) {
+    write(LogRecord{LogLevel::INFO, {}, std::chrono::system_clock::now()}, message);
+}
+
+void ShardedFileAppender::write(const LogRecord& record, const std::string& message) {
+    try {
+        const auto timestampNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            record.timestamp.time_since_epoch()).count();
+        Shard& shard = currentShard();
+        std::lock_guard<std::mutex> lock(shard.mutex);
+
+        char prefix[kTimestampPrefix + 1];
+        std::snprintf(prefix, sizeof(prefix), "%019lld ", static_cast<long long>(timestampNs));
+        shard.line.assign(prefix, kTimestampPrefix);
+        shard.line.append(message);
+        shard.file.write(timestampNs, shard.line);
+    } catch (const std::exception& e) {
+        std::cerr << "ShardedFileAppender error: " << e.what() << std::endl;
+        throw;
+    }
+}
+
+void ShardedFileAppender::flush() {
+    std::lock_guard<std::mutex> lock(shardsMutex_);
+    for (auto& [tid, shard] : shards_) {
+        std::lock_guard<std::mutex> shardLock(shard->mutex);
+        shard->file.flush();
+    }
+    closeExited();
+}
+
+void ShardedFileAppender::closeExited() {
+    // A dead thread's cache entry died with it, so nothing points at its
+    // shard. A thread that is later given the same id reopens the same file.
+    for (auto it = shards_.begin(); it != shards_.end();) {
+        if (!threadExited(it->first)) {
+            ++it;
+            continue;
+        }
+        try {
+            it->second->file.flush();
+        } catch (const std::exception& e) {
+            std::cerr << "ShardedFileAppender error: " << e.what() << std::endl;
+        }
+        it = shards_.erase(it); // Closes the file
+    }
+}
+
+int ShardedFileAppender::emergencyFlush() noexcept {
+    for (auto& [tid, shard] : shards_) {
+        shard->file.emergencyFlush();
+    }
+    return -1;
+}
+
+void ShardedFileAppender::prepareFork() {
+    shardsMutex_.lock();
+    for (auto& [tid, shard] : shards_) {
+        shard->mutex.lock();
+        try {
+            shard->file.flush();
+        } catch (const std::exception& e) {
+            std::cerr << "ShardedFileAppender error: " << e.what() << std::endl;
+        }
+    }
+}
+
+void ShardedFileAppender::afterFork(bool child) {
+    for (auto& [tid, shard] : shards_) {
+        if (child) {
+            shard->file.reopenAfterFork(); // Closes without writing the parent's buffer
+        }
+        shard->mutex.unlock();
+    }
+    if (child) {
+        shards_.clear();
+        id_ = nextAppenderId.fetch_add(1); // Invalidates the forking thread's cache entry
+    }
+    shardsMutex_.unlock();
+}
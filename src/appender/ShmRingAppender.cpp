@@ -0,0 +1,42 @@
+#include "opLog/appender/ShmRingAppender.h"
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <unistd.h>
+#include "opLog/Config.h"
+#include "opLog/shm/ShmRing.h"
+
+namespace {
+    std::mutex ringMutex;
+    std::unique_ptr<ShmRing> ring;
+
+    // Created on first use, and again on first use after a fork
+    ShmRing* processRing() {
+        std::lock_guard<std::mutex> lock(ringMutex);
+        if (!ring || ring->ownerPid() != ::getpid()) {
+            const auto& config = opLog::Config::getInstance();
+            const std::string name = "/" + config.getShmRingPrefix() + "-" + std::to_string(::getpid());
+            ring.reset(ShmRing::create(name, config.getShmRingSlots())); // Unmaps the parent's
+        }
+        return ring.get();
+    }
+}
+
+ShmRingAppender::ShmRingAppender() : ring_(processRing()) {}
+
+void ShmRingAppender::afterFork(bool child) {
+    if (child) {
+        ring_ = processRing();
+    }
+}
+
+void ShmRingAppender::write(const std::string& message) {
+    write(LogRecord{LogLevel::INFO, message, std::chrono::system_clock::now()}, message);
+}
+
+void ShmRingAppender::write(const LogRecord& record, const std::string& message) {
+    (void)message; // The collector formats on its side
+    const auto timestampNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        record.timestamp.time_since_epoch()).count();
+    ring_->tryWrite(timestampNs, record.logLevel, record.message.data(), record.message.size());
+}
@@ -0,0 +1,213 @@
+#include "opLog/appender/TimeIndex.h"
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "opLog/Config.h"
+
+namespace {
+    constexpr long long NANOS_PER_SECOND = 1000000000LL;
+    constexpr size_t LEVEL_SCAN_LIMIT = 160;
+
+    const char* const LEVEL_NAMES[] = {"TRACE", "DEBUG", "INFO", "WARN", "ERROR", "FATAL"};
+
+    bool writeAll(int fd, const void* data, size_t size) {
+        const char* bytes = static_cast<const char*>(data);
+        while (size > 0) {
+            const ssize_t n = ::write(fd, bytes, size);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                return false;
+            }
+            bytes += n;
+            size -= static_cast<size_t>(n);
+        }
+        return true;
+    }
+}
+
+TimeIndex::TimeIndex(std::size_t everyRecords, std::size_t everyBytes)
+    : everyRecords_(everyRecords == 0 ? 1 : everyRecords),
+      everyBytes_(everyBytes == 0 ? SIZE_MAX : everyBytes) {}
+
+TimeIndex::~TimeIndex() {
+    close();
+}
+
+void TimeIndex::open(const std::string& logPath) {
+    close();
+
+    const std::string indexPath = logPath + kSuffix;
+    struct stat logStat{};
+    const std::uint64_t logSize = ::stat(logPath.c_str(), &logStat) == 0 ? logStat.st_size : 0;
+
+    std::vector<Entry> entries = load(indexPath, logSize);
+    struct stat indexStat{};
+    const bool indexExists = ::stat(indexPath.c_str(), &indexStat) == 0;
+    bool changed = !indexExists ||
+                   static_cast<std::uint64_t>(indexStat.st_size) != sizeof(kMagic) + entries.size() * sizeof(Entry);
+
+    // Index whatever the log holds past the last valid entry
+    const std::uint64_t from = entries.empty() ? 0 : entries.back().offset;
+    if (logSize > from) {
+        const int logFd = ::open(logPath.c_str(), O_RDONLY | O_CLOEXEC);
+        void* data = logFd < 0 ? MAP_FAILED : ::mmap(nullptr, logSize, PROT_READ, MAP_PRIVATE, logFd, 0);
+        if (logFd >= 0) ::close(logFd);
+        if (data != MAP_FAILED) {
+            const size_t before = entries.size();
+            build(static_cast<const char*>(data), logSize, from, opLog::Config::getInstance().getDateTimeFormat(),
+                  everyRecords_, everyBytes_, entries);
+            ::munmap(data, logSize);
+            changed = changed || entries.size() != before;
+        }
+    }
+
+    if (changed && !save(indexPath, entries)) {
+        throw std::runtime_error("Error writing index file: " + indexPath + ": " + std::strerror(errno));
+    }
+
+    fd_ = ::open(indexPath.c_str(), O_WRONLY | O_APPEND | O_CLOEXEC);
+    if (fd_ < 0) {
+        throw std::runtime_error("Error opening index file: " + indexPath + ": " + std::strerror(errno));
+    }
+
+    if (entries.empty()) {
+        records_ = everyRecords_ - 1; // First record gets an entry
+        lastOffset_ = 0;
+    } else {
+        records_ = 0;
+        lastOffset_ = entries.back().offset;
+    }
+}
+
+void TimeIndex::close() {
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+}
+
+void TimeIndex::add(long long timestampNs, std::uint64_t offset) {
+    records_ = 0;
+    lastOffset_ = offset;
+    if (fd_ >= 0) {
+        const Entry entry{timestampNs, offset};
+        writeAll(fd_, &entry, sizeof(entry)); // Best effort: repaired on next open
+    }
+}
+
+std::vector<TimeIndex::Entry> TimeIndex::load(const std::string& indexPath, std::uint64_t logSize) {
+    std::vector<Entry> entries;
+    const int fd = ::open(indexPath.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return entries;
+    }
+
+    char magic[sizeof(kMagic)];
+    if (::read(fd, magic, sizeof(magic)) == sizeof(magic) && std::memcmp(magic, kMagic, sizeof(kMagic)) == 0) {
+        Entry entry{};
+        while (::read(fd, &entry, sizeof(entry)) == sizeof(entry)) {
+            // Stop at the first entry the log does not back up
+            if (entry.offset >= logSize || (!entries.empty() && entry.offset < entries.back().offset)) {
+                break;
+            }
+            entries.push_back(entry);
+        }
+    }
+    ::close(fd);
+    return entries;
+}
+
+void TimeIndex::build(const char* data, std::size_t size, std::uint64_t from,
+                      const std::string& dateTimeFormat, std::size_t everyRecords, std::size_t everyBytes,
+                      std::vector<Entry>& entries) {
+    std::size_t records = entries.empty() ? everyRecords - 1 : 0;
+    std::uint64_t lastOffset = entries.empty() ? 0 : entries.back().offset;
+    bool first = !entries.empty(); // The line at `from` is already indexed
+
+    std::uint64_t offset = from;
+    while (offset < size) {
+        const void* newline = std::memchr(data + offset, '\n', size - offset);
+        const std::uint64_t end = newline ? static_cast<const char*>(newline) - data + 1 : size;
+
+        long long timestampNs;
+        if (first) {
+            first = false;
+        } else if ((++records >= everyRecords || offset - lastOffset >= everyBytes) &&
+                   parseTimestamp(data + offset, end - offset, dateTimeFormat, timestampNs)) {
+            entries.push_back({timestampNs, offset});
+            records = 0;
+            lastOffset = offset;
+        }
+        offset = end;
+    }
+}
+
+bool TimeIndex::save(const std::string& indexPath, const std::vector<Entry>& entries) {
+    const int fd = ::open(indexPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        return false;
+    }
+    const bool ok = writeAll(fd, kMagic, sizeof(kMagic)) &&
+                    writeAll(fd, entries.data(), entries.size() * sizeof(Entry));
+    ::close(fd);
+    return ok;
+}
+
+bool TimeIndex::parseTimestamp(const char* line, std::size_t length, const std::string& dateTimeFormat,
+                               long long& timestampNs) {
+    if (length > 0 && line[0] == '[') {
+        ++line;
+        --length;
+    }
+
+    char text[96];
+    const size_t n = length < sizeof(text) - 1 ? length : sizeof(text) - 1;
+    std::memcpy(text, line, n);
+    text[n] = '\0';
+
+    std::tm local{};
+    if (strptime(text, dateTimeFormat.c_str(), &local) == nullptr) {
+        return false;
+    }
+    local.tm_isdst = -1;
+    const std::time_t seconds = std::mktime(&local);
+    if (seconds == static_cast<std::time_t>(-1)) {
+        return false;
+    }
+    timestampNs = static_cast<long long>(seconds) * NANOS_PER_SECOND;
+    return true;
+}
+
+int TimeIndex::parseLevel(const char* line, std::size_t length) {
+    const size_t limit = length < LEVEL_SCAN_LIMIT ? length : LEVEL_SCAN_LIMIT;
+    size_t i = 0;
+    while (i < limit) {
+        if (line[i] == '\033') {
+            // Skip ESC [ ... final byte
+            ++i;
+            if (i < limit && line[i] == '[') ++i;
+            while (i < limit && (line[i] < 0x40 || line[i] > 0x7e)) ++i;
+            ++i;
+            continue;
+        }
+        if (line[i] < 'A' || line[i] > 'Z') {
+            ++i;
+            continue;
+        }
+
+        const size_t start = i;
+        while (i < limit && line[i] >= 'A' && line[i] <= 'Z') ++i;
+        for (int level = 0; level < 6; ++level) {
+            const size_t nameLength = std::strlen(LEVEL_NAMES[level]);
+            if (i - start == nameLength && std::memcmp(line + start, LEVEL_NAMES[level], nameLength) == 0) {
+                return level;
+            }
+        }
+    }
+    return -1;
+}
@@ -0,0 +1,271 @@
+#include "opLog/appender/UnixSocketAppender.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "opLog/Config.h"
+#include "opLog/ForkHandler.h"
+
+namespace {
+    constexpr size_t BATCH_RECORDS = 64;
+    constexpr auto MIN_BACKOFF = std::chrono::milliseconds(100);
+    constexpr auto MAX_BACKOFF = std::chrono::seconds(5);
+    constexpr timeval SEND_TIMEOUT{1, 0}; // Lets the sender notice stop_ while the agent stalls
+}
+
+UnixSocketAppender::UnixSocketAppender() {
+    const auto& config = opLog::Config::getInstance();
+    path_ = config.getSocketPath();
+    stream_ = config.isSocketStream();
+    bufferLimit_ = config.getSocketBufferBytes();
+    sender_ = std::thread(&UnixSocketAppender::run, this);
+}
+
+UnixSocketAppender::~UnixSocketAppender() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    wake_.notify_all();
+    sender_.join();
+    disconnect();
+
+    if (const std::uint64_t dropped = droppedRecords()) {
+        std::cerr << "UnixSocketAppender: dropped " << dropped << " records for " << path_ << std::endl;
+    }
+}
+
+void UnixSocketAppender::write(const std::string& message) {
+    write(LogRecord{LogLevel::INFO, {}, std::chrono::system_clock::now()}, message);
+}
+
+void UnixSocketAppender::write(const LogRecord& record, const std::string& message) {
+    (void)record;
+    std::string entry;
+    entry.reserve(message.size() + 1);
+    entry.append(message);
+    if (stream_) {
+        entry.push_back('\n');
+    }
+
+    bool wasEmpty;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (queuedBytes_ + entry.size() > bufferLimit_) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        queuedBytes_ += entry.size();
+        memory_.set(queuedBytes_);
+        wasEmpty = queue_.empty();
+        queue_.push_back(std::move(entry));
+    }
+    if (wasEmpty) {
+        wake_.notify_one(); // The sender only sleeps on an empty queue
+    }
+}
+
+void UnixSocketAppender::flush() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    drained_.wait(lock, [this] { return (queue_.empty() && inFlight_ == 0) || agentDown_ || stop_; });
+}
+
+int UnixSocketAppender::emergencyFlush() noexcept {
+    const int fd = fd_;
+    if (fd < 0) {
+        return -1;
+    }
+    for (const std::string& entry : queue_) {
+        if (::send(fd, entry.data(), entry.size(), MSG_NOSIGNAL | MSG_DONTWAIT) < 0) {
+            break;
+        }
+    }
+    return -1;
+}
+
+bool UnixSocketAppender::connect() {
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (path_.size() >= sizeof(address.sun_path)) {
+        return false;
+    }
+    std::memcpy(address.sun_path, path_.c_str(), path_.size() + 1);
+
+    fd_ = ::socket(AF_UNIX, (stream_ ? SOCK_STREAM : SOCK_DGRAM) | SOCK_CLOEXEC, 0);
+    if (fd_ < 0) {
+        return false;
+    }
+    ::setsockopt(fd_, SOL_SOCKET, SO_SNDTIMEO, &SEND_TIMEOUT, sizeof(SEND_TIMEOUT));
+    if (::connect(fd_, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0) {
+        disconnect();
+        return false;
+    }
+    return true;
+}
+
+void UnixSocketAppender::prepareFork() {
+    mutex_.lock();
+}
+
+void UnixSocketAppender::afterFork(bool child) {
+    if (child) {
+        ForkHandler::reinitialize(sender_);
+        ForkHandler::reinitialize(wake_);
+        ForkHandler::reinitialize(drained_);
+        disconnect(); // The parent's connection
+        queue_.clear();
+        queuedBytes_ = 0;
+        memory_.set(0);
+        inFlight_ = 0;
+        agentDown_ = false;
+    }
+    mutex_.unlock();
+    if (child) {
+        sender_ = std::thread(&UnixSocketAppender::run, this);
+    }
+}
+
+void UnixSocketAppender::disconnect() {
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+    streamOffset_ = 0; // A new connection gets whole records
+}
+
+void UnixSocketAppender::run() {
+    std::vector<std::string> batch;
+    batch.reserve(BATCH_RECORDS);
+    auto backoff = std::chrono::milliseconds(MIN_BACKOFF);
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        wake_.wait(lock, [this] { return stop_ || !queue_.empty(); });
+        if (queue_.empty()) {
+            break; // Stopping with nothing left to send
+        }
+
+        if (fd_ < 0) {
+            lock.unlock();
+            const bool connected = connect();
+            lock.lock();
+            if (!connected) {
+                agentDown_ = true;
+                drained_.notify_all();
+                if (stop_) {
+                    break;
+                }
+                wake_.wait_for(lock, backoff, [this] { return stop_.load(); });
+                backoff = std::min<std::chrono::milliseconds>(backoff * 2, MAX_BACKOFF);
+                continue;
+            }
+            agentDown_ = false;
+            backoff = MIN_BACKOFF;
+        }
+
+        const size_t count = std::min(queue_.size(), BATCH_RECORDS);
+        for (size_t i = 0; i < count; ++i) {
+            batch.push_back(std::move(queue_.front()));
+            queue_.pop_front();
+        }
+        inFlight_ = count;
+        lock.unlock();
+
+        const size_t sent = stream_ ? sendStream(batch) : sendDatagrams(batch);
+
+        lock.lock();
+        for (size_t i = 0; i < sent; ++i) {
+            queuedBytes_ -= batch[i].size();
+        }
+        memory_.set(queuedBytes_);
+        for (size_t i = batch.size(); i-- > sent;) {
+            queue_.push_front(std::move(batch[i])); // Back in order for the retry
+        }
+        batch.clear();
+        inFlight_ = 0;
+        if (queue_.empty()) {
+            drained_.notify_all();
+        }
+        if (sent == 0 && fd_ >= 0 && stop_) {
+            break; // Agent stalled during shutdown: give up on the rest
+        }
+    }
+
+    dropped_.fetch_add(queue_.size(), std::memory_order_relaxed); // Never reached the agent
+    agentDown_ = true;
+    drained_.notify_all();
+}
+
+// Returns how many records of `batch` left the process (or were dropped)
+size_t UnixSocketAppender::sendDatagrams(std::vector<std::string>& batch) {
+    mmsghdr messages[BATCH_RECORDS]{};
+    iovec iov[BATCH_RECORDS];
+    for (size_t i = 0; i < batch.size(); ++i) {
+        iov[i] = {batch[i].data(), batch[i].size()};
+        messages[i].msg_hdr.msg_iov = &iov[i];
+        messages[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    size_t sent = 0;
+    while (sent < batch.size()) {
+        const int n = ::sendmmsg(fd_, messages + sent, static_cast<unsigned>(batch.size() - sent), MSG_NOSIGNAL);
+        if (n > 0) {
+            sent += static_cast<size_t>(n);
+            continue;
+        }
+        if (errno == EINTR) {
+            continue;
+        }
+        if (errno == EMSGSIZE) {
+            dropped_.fetch_add(1, std::memory_order_relaxed); // Can never be sent
+            ++sent;
+            continue;
+        }
+        if (errno != EAGAIN && errno != EWOULDBLOCK && errno != ENOBUFS) {
+            disconnect(); // Agent went away; reconnect before retrying
+        }
+        break;
+    }
+    return sent;
+}
+
+size_t UnixSocketAppender::sendStream(std::vector<std::string>& batch) {
+    iovec iov[BATCH_RECORDS];
+    size_t sent = 0;
+    while (sent < batch.size()) {
+        const size_t count = batch.size() - sent;
+        for (size_t i = 0; i < count; ++i) {
+            iov[i] = {batch[sent + i].data(), batch[sent + i].size()};
+        }
+        iov[0].iov_base = static_cast<char*>(iov[0].iov_base) + streamOffset_;
+        iov[0].iov_len -= streamOffset_;
+
+        msghdr message{};
+        message.msg_iov = iov;
+        message.msg_iovlen = count;
+        ssize_t n = ::sendmsg(fd_, &message, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                disconnect();
+            }
+            break;
+        }
+
+        // Retire whole records; remember how far into a split one we got
+        auto remaining = static_cast<size_t>(n);
+        while (sent < batch.size() && remaining >= batch[sent].size() - streamOffset_) {
+            remaining -= batch[sent].size() - streamOffset_;
+            streamOffset_ = 0;
+            ++sent;
+        }
+        streamOffset_ += remaining;
+    }
+    return sent;
+}
@@ -0,0 +1,118 @@
+#include "opLog/binary/BinaryLogReader.h"
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "opLog/binary/BinaryLogFormat.h"
+
+using BinaryLogFormat::BlockHeader;
+
+BinaryLogReader::BinaryLogReader(const std::string& path) {
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        throw std::runtime_error("Cannot open " + path + ": " + std::strerror(errno));
+    }
+    struct stat st{};
+    if (::fstat(fd, &st) != 0) {
+        ::close(fd);
+        throw std::runtime_error("Cannot stat " + path + ": " + std::strerror(errno));
+    }
+
+    size_ = static_cast<std::size_t>(st.st_size);
+    if (size_ > 0) {
+        void* mapping = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping == MAP_FAILED) {
+            ::close(fd);
+            throw std::runtime_error("Cannot map " + path + ": " + std::strerror(errno));
+        }
+        data_ = static_cast<const char*>(mapping);
+    }
+    ::close(fd);
+
+    // Walk the headers only
+    std::uint64_t offset = 0;
+    while (offset + sizeof(BlockHeader) <= size_) {
+        BlockHeader header;
+        std::memcpy(&header, data_ + offset, sizeof(header));
+        if (header.magic != BinaryLogFormat::kBlockMagic || header.version != BinaryLogFormat::kVersion ||
+            offset + sizeof(header) + header.payloadSize > size_) {
+            break;
+        }
+        blocks_.push_back({offset, header.recordCount, header.minTimestampNs, header.maxTimestampNs,
+                           static_cast<LogLevel>(header.minLevel), static_cast<LogLevel>(header.maxLevel)});
+        offset += sizeof(header) + header.payloadSize;
+    }
+    truncated_ = offset != size_;
+}
+
+BinaryLogReader::~BinaryLogReader() {
+    if (data_) {
+        ::munmap(const_cast<char*>(data_), size_);
+    }
+}
+
+bool BinaryLogReader::decodeBlock(std::size_t index, const Visitor& visitor) const {
+    BlockHeader header;
+    std::memcpy(&header, data_ + blocks_.at(index).offset, sizeof(header));
+    const char* pos = data_ + blocks_[index].offset + sizeof(header);
+    const char* end = pos + header.payloadSize;
+    if (BinaryLogFormat::checksum(pos, header.payloadSize) != header.checksum || header.recordCount == 0) {
+        return false;
+    }
+
+    const std::uint32_t count = header.recordCount;
+    std::vector<long long> timestamps(count);
+    std::int64_t first;
+    if (end - pos < static_cast<std::ptrdiff_t>(sizeof(first))) return false;
+    std::memcpy(&first, pos, sizeof(first));
+    pos += sizeof(first);
+    timestamps[0] = first;
+    for (std::uint32_t i = 1; i < count; ++i) {
+        std::uint64_t delta;
+        if (!BinaryLogFormat::getVarint(pos, end, delta)) return false;
+        timestamps[i] = timestamps[i - 1] + BinaryLogFormat::unzigzag(delta);
+    }
+
+    if (end - pos < static_cast<std::ptrdiff_t>(count)) return false;
+    const char* levels = pos;
+    pos += count;
+
+    std::vector<std::string_view> dictionary(header.dictionaryCount);
+    for (auto& message : dictionary) {
+        std::uint64_t length;
+        if (!BinaryLogFormat::getVarint(pos, end, length) || length > static_cast<std::uint64_t>(end - pos)) {
+            return false;
+        }
+        message = std::string_view(pos, length);
+        pos += length;
+    }
+
+    for (std::uint32_t i = 0; i < count; ++i) {
+        std::uint64_t id;
+        if (!BinaryLogFormat::getVarint(pos, end, id) || id >= dictionary.size()) return false;
+        visitor(timestamps[i], static_cast<LogLevel>(levels[i]), dictionary[id]);
+    }
+    return true;
+}
+
+std::size_t BinaryLogReader::read(const Filter& filter, const Visitor& visitor) const {
+    std::size_t decoded = 0;
+    for (std::size_t i = 0; i < blocks_.size(); ++i) {
+        const BlockInfo& block = blocks_[i];
+        if (block.maxTimestampNs < filter.fromNs || block.minTimestampNs > filter.toNs ||
+            block.maxLevel < filter.minLevel) {
+            continue; // Summary rules the whole block out
+        }
+
+        ++decoded;
+        decodeBlock(i, [&](long long timestampNs, LogLevel level, std::string_view message) {
+            if (timestampNs >= filter.fromNs && timestampNs <= filter.toNs && level >= filter.minLevel) {
+                visitor(timestampNs, level, message);
+            }
+        });
+    }
+    return decoded;
+}
@@ -0,0 +1,244 @@
+#include "opLog/compression/Compressor.h"
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+
+#ifdef OPLOG_HAVE_ZLIB
+#include <zlib.h>
+#endif
+#ifdef OPLOG_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+namespace {
+    constexpr size_t CHUNK_SIZE = 128 * 1024;
+
+    // Owns a file descriptor for the duration of a compression job
+    class FileHandle {
+        int fd_;
+    public:
+        FileHandle(const std::string& path, int flags) : fd_(::open(path.c_str(), flags | O_CLOEXEC, 0644)) {
+            if (fd_ < 0) {
+                throw std::runtime_error("Cannot open " + path + ": " + std::strerror(errno));
+            }
+        }
+        ~FileHandle() { ::close(fd_); }
+        FileHandle(const FileHandle&) = delete;
+        FileHandle& operator=(const FileHandle&) = delete;
+
+        size_t read(char* data, size_t size) {
+            ssize_t n;
+            do {
+                n = ::read(fd_, data, size);
+            } while (n < 0 && errno == EINTR);
+            if (n < 0) {
+                throw std::runtime_error(std::string("Read failed: ") + std::strerror(errno));
+            }
+            return static_cast<size_t>(n);
+        }
+
+        void write(const char* data, size_t size) {
+            while (size > 0) {
+                const ssize_t n = ::write(fd_, data, size);
+                if (n < 0) {
+                    if (errno == EINTR) continue;
+                    throw std::runtime_error(std::string("Write failed: ") + std::strerror(errno));
+                }
+                data += n;
+                size -= static_cast<size_t>(n);
+            }
+        }
+
+        void sync() {
+            if (::fsync(fd_) != 0) {
+                throw std::runtime_error(std::string("fsync failed: ") + std::strerror(errno));
+            }
+        }
+    };
+
+#ifdef OPLOG_HAVE_ZLIB
+    void gzipFile(FileHandle& in, FileHandle& out) {
+        z_stream stream{};
+        // 15 window bits + 16 selects the gzip wrapper
+        if (deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+            throw std::runtime_error("deflateInit2 failed");
+        }
+
+        std::vector<char> input(CHUNK_SIZE);
+        std::vector<char> output(CHUNK_SIZE);
+        int flush = Z_NO_FLUSH;
+        try {
+            do {
+                const size_t n = in.read(input.data(), input.size());
+                flush = n == 0 ? Z_FINISH : Z_NO_FLUSH;
+                stream.next_in = reinterpret_cast<Bytef*>(input.data());
+                stream.avail_in = static_cast<uInt>(n);
+                do {
+                    stream.next_out = reinterpret_cast<Bytef*>(output.data());
+                    stream.avail_out = static_cast<uInt>(output.size());
+                    deflate(&stream, flush);
+                    out.write(output.data(), output.size() - stream.avail_out);
+                } while (stream.avail_out == 0);
+            } while (flush != Z_FINISH);
+        } catch (...) {
+            deflateEnd(&stream);
+            throw;
+        }
+        deflateEnd(&stream);
+    }
+#endif
+
+#ifdef OPLOG_HAVE_ZSTD
+    void zstdFile(FileHandle& in, FileHandle& out) {
+        ZSTD_CCtx* ctx = ZSTD_createCCtx();
+        if (ctx == nullptr) {
+            throw std::runtime_error("ZSTD_createCCtx failed");
+        }
+
+        std::vector<char> input(ZSTD_CStreamInSize());
+        std::vector<char> output(ZSTD_CStreamOutSize());
+        try {
+            bool finished = false;
+            while (!finished) {
+                const size_t n = in.read(input.data(), input.size());
+                const ZSTD_EndDirective mode = n == 0 ? ZSTD_e_end : ZSTD_e_continue;
+                ZSTD_inBuffer source{input.data(), n, 0};
+                size_t remaining;
+                do {
+                    ZSTD_outBuffer sink{output.data(), output.size(), 0};
+                    remaining = ZSTD_compressStream2(ctx, &sink, &source, mode);
+                    if (ZSTD_isError(remaining)) {
+                        throw std::runtime_error(std::string("zstd: ") + ZSTD_getErrorName(remaining));
+                    }
+                    out.write(output.data(), sink.pos);
+                } while (mode == ZSTD_e_end ? remaining != 0 : source.pos < source.size);
+                finished = mode == ZSTD_e_end;
+            }
+        } catch (...) {
+            ZSTD_freeCCtx(ctx);
+            throw;
+        }
+        ZSTD_freeCCtx(ctx);
+    }
+#endif
+}
+
+bool Compressor::isAvailable(CompressionCodec codec) {
+    switch (codec) {
+        case CompressionCodec::NONE: return true;
+#ifdef OPLOG_HAVE_ZLIB
+        case CompressionCodec::GZIP: return true;
+#endif
+#ifdef OPLOG_HAVE_ZSTD
+        case CompressionCodec::ZSTD: return true;
+#endif
+        default: return false;
+    }
+}
+
+const char* Compressor::extension(CompressionCodec codec) {
+    switch (codec) {
+        case CompressionCodec::GZIP: return ".gz";
+        case CompressionCodec::ZSTD: return ".zst";
+        default: return "";
+    }
+}
+
+void Compressor::compressFile(const std::string& source, const std::string& destination, CompressionCodec codec) {
+    if (!isAvailable(codec) || codec == CompressionCodec::NONE) {
+        throw std::runtime_error("Compression codec not available");
+    }
+
+    FileHandle in(source, O_RDONLY);
+    FileHandle out(destination, O_WRONLY | O_CREAT | O_TRUNC);
+    switch (codec) {
+#ifdef OPLOG_HAVE_ZLIB
+        case CompressionCodec::GZIP: gzipFile(in, out); break;
+#endif
+#ifdef OPLOG_HAVE_ZSTD
+        case CompressionCodec::ZSTD: zstdFile(in, out); break;
+#endif
+        default: break;
+    }
+    out.sync();
+}
+
+FrameEncoder::FrameEncoder(CompressionCodec codec) : codec_(codec) {
+    if (!Compressor::isAvailable(codec) || codec == CompressionCodec::NONE) {
+        throw std::runtime_error("Compression codec not available");
+    }
+
+#ifdef OPLOG_HAVE_ZLIB
+    if (codec_ == CompressionCodec::GZIP) {
+        auto* stream = new z_stream{};
+        if (deflateInit2(stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+            delete stream;
+            throw std::runtime_error("deflateInit2 failed");
+        }
+        state_ = stream;
+    }
+#endif
+#ifdef OPLOG_HAVE_ZSTD
+    if (codec_ == CompressionCodec::ZSTD) {
+        state_ = ZSTD_createCCtx();
+        if (state_ == nullptr) {
+            throw std::runtime_error("ZSTD_createCCtx failed");
+        }
+    }
+#endif
+}
+
+FrameEncoder::~FrameEncoder() {
+#ifdef OPLOG_HAVE_ZLIB
+    if (codec_ == CompressionCodec::GZIP) {
+        auto* stream = static_cast<z_stream*>(state_);
+        deflateEnd(stream);
+        delete stream;
+    }
+#endif
+#ifdef OPLOG_HAVE_ZSTD
+    if (codec_ == CompressionCodec::ZSTD) {
+        ZSTD_freeCCtx(static_cast<ZSTD_CCtx*>(state_));
+    }
+#endif
+}
+
+void FrameEncoder::encode(const char* data, size_t size, std::string& out) {
+    const size_t offset = out.size();
+
+#ifdef OPLOG_HAVE_ZLIB
+    if (codec_ == CompressionCodec::GZIP) {
+        auto* stream = static_cast<z_stream*>(state_);
+        deflateReset(stream); // Each frame is its own gzip member
+
+        // deflateBound does not include the gzip wrapper
+        out.resize(offset + deflateBound(stream, static_cast<uLong>(size)) + 18);
+        stream->next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+        stream->avail_in = static_cast<uInt>(size);
+        stream->next_out = reinterpret_cast<Bytef*>(out.data() + offset);
+        stream->avail_out = static_cast<uInt>(out.size() - offset);
+        if (deflate(stream, Z_FINISH) != Z_STREAM_END) {
+            out.resize(offset);
+            throw std::runtime_error("deflate failed");
+        }
+        out.resize(out.size() - stream->avail_out);
+    }
+#endif
+#ifdef OPLOG_HAVE_ZSTD
+    if (codec_ == CompressionCodec::ZSTD) {
+        out.resize(offset + ZSTD_compressBound(size));
+        const size_t written = ZSTD_compressCCtx(static_cast<ZSTD_CCtx*>(state_), out.data() + offset,
+                                                 out.size() - offset, data, size, ZSTD_CLEVEL_DEFAULT);
+        if (ZSTD_isError(written)) {
+            out.resize(offset);
+            throw std::runtime_error(std::string("zstd: ") + ZSTD_getErrorName(written));
+        }
+        out.resize(offset + written);
+    }
+#endif
+    (void)data;
+    (void)size;
+}
@@ -0,0 +1,110 @@
+#include "opLog/formatter/MessageSanitizer.h"
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+namespace {
+    constexpr char HEX_DIGITS[] = "0123456789abcdef";
+
+    bool isUnsafe(unsigned char c) {
+        return c < 0x20 || c == 0x7f;
+    }
+
+    std::size_t findScalar(const char* data, std::size_t from, std::size_t size) {
+        for (std::size_t i = from; i < size; ++i) {
+            if (isUnsafe(static_cast<unsigned char>(data[i]))) {
+                return i;
+            }
+        }
+        return size;
+    }
+
+#if defined(__x86_64__)
+    // A byte is unsafe if min(byte, 0x1f) == byte (unsigned) or it is 0x7f.
+    // Both return the offset of the first unsafe byte, or where the whole
+    // blocks end if there is none in them.
+    std::size_t findSse2(const char* data, std::size_t size) {
+        const __m128i limit = _mm_set1_epi8(0x1f);
+        const __m128i del = _mm_set1_epi8(0x7f);
+
+        std::size_t i = 0;
+        for (; i + 16 <= size; i += 16) {
+            const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+            const __m128i unsafe = _mm_or_si128(_mm_cmpeq_epi8(_mm_min_epu8(bytes, limit), bytes),
+                                                _mm_cmpeq_epi8(bytes, del));
+            const int mask = _mm_movemask_epi8(unsafe);
+            if (mask != 0) {
+                return i + static_cast<std::size_t>(__builtin_ctz(static_cast<unsigned>(mask)));
+            }
+        }
+        return i;
+    }
+
+    __attribute__((target("avx2")))
+    std::size_t findAvx2(const char* data, std::size_t size) {
+        const __m256i limit = _mm256_set1_epi8(0x1f);
+        const __m256i del = _mm256_set1_epi8(0x7f);
+
+        std::size_t i = 0;
+        for (; i + 32 <= size; i += 32) {
+            const __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+            const __m256i unsafe = _mm256_or_si256(_mm256_cmpeq_epi8(_mm256_min_epu8(bytes, limit), bytes),
+                                                   _mm256_cmpeq_epi8(bytes, del));
+            const unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(unsafe));
+            if (mask != 0) {
+                return i + static_cast<std::size_t>(__builtin_ctz(mask));
+            }
+        }
+        return i;
+    }
+
+    bool hasAvx2() {
+        static const bool supported = (__builtin_cpu_init(), __builtin_cpu_supports("avx2") != 0);
+        return supported;
+    }
+#endif
+}
+
+std::size_t MessageSanitizer::findUnsafe(const char* data, std::size_t size) {
+    std::size_t i = 0;
+#if defined(__x86_64__)
+    if (hasAvx2()) {
+        i = findAvx2(data, size);
+    }
+    if (i + 16 <= size) {
+        i += findSse2(data + i, size - i);
+    }
+#endif
+    return findScalar(data, i, size);
+}
+
+void MessageSanitizer::appendEscaped(std::string& out, std::string_view text) {
+    const char* data = text.data();
+    const std::size_t size = text.size();
+    std::size_t from = 0;
+    while (from < size) {
+        const std::size_t at = from + findUnsafe(data + from, size - from);
+        out.append(data + from, at - from);
+        if (at == size) {
+            break;
+        }
+        const auto c = static_cast<unsigned char>(data[at]);
+        switch (c) {
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default: {
+                const char hex[] = {'\\', 'x', HEX_DIGITS[c >> 4], HEX_DIGITS[c & 0x0f]};
+                out.append(hex, sizeof(hex));
+            }
+        }
+        from = at + 1;
+    }
+}
+
+std::string MessageSanitizer::escape(std::string_view text) {
+    std::string out;
+    out.reserve(text.size() + 16);
+    appendEscaped(out, text);
+    return out;
+}
@@ -1,14 +1,14 @@
 #include "opLog/formatter/PlainTextFormatter.h"
 #include "opLog/Config.h"
+#include "opLog/formatter/MessageSanitizer.h"
 #include<array>
 #include <iomanip>
 #include <sstream>
 
 PlainTextFormatter::PlainTextFormatter(const FormatStyle style) : style(style) {}
 
-std::string PlainTextFormatter::logLevelToString(const LogLevel& logLevel) {
+std::string PlainTextFormatter::logLevelToString(const opLog::Config& config, const LogLevel& logLevel) {
     const auto idx = static_cast<size_t>(logLevel);
-    const auto& config = opLog::Config::getInstance();
     const auto& colors = config.getColors();
 
     static constexpr const char* LOG_LEVEL_STRINGS[]{
@@ -33,37 +33,56 @@ std::string PlainTextFormatter::format(const LogRecord& record) {
         return ""; // Skip this message
     }
 
+    return formatUnfiltered(record);
+}
+
+std::string PlainTextFormatter::formatUnfiltered(const LogRecord& record) {
+    // One load, so a reload never mixes old and new settings in one line
+    const auto& config = opLog::Config::getInstance();
+
+    // Clean messages, the common case, are only scanned, never copied
+    std::string escaped;
+    const std::string_view text = record.message;
+    const std::size_t unsafe = config.isSanitizeMessagesEnabled()
+        ? MessageSanitizer::findUnsafe(text.data(), text.size()) : text.size();
+    const bool sanitize = unsafe != text.size();
+    if (sanitize) {
+        escaped.reserve(text.size() + 16);
+        escaped.append(text.data(), unsafe);
+        MessageSanitizer::appendEscaped(escaped, text.substr(unsafe));
+    }
+    const std::string& message = sanitize ? escaped : record.message;
+
     std::ostringstream oss;
 
     // Add timestamp if enabled
     if (config.isTimestampEnabled()) {
         const std::time_t time = std::chrono::system_clock::to_time_t(record.timestamp);
-        const std::tm* localTime = std::localtime(&time);
+        std::tm localTimeBuffer{};
+        const std::tm* localTime = ::localtime_r(&time, &localTimeBuffer);
 
         // Use format style from config (or override with constructor parameter)
-        FormatStyle actualStyle = (style != FormatStyle::STYLE_WITH_BRACKETS &&
-                                  style != FormatStyle::STYLE_NO_BRACKETS) ?
-                                 config.getFormatStyle() : style;
+        const FormatStyle actualStyle = style.value_or(config.getFormatStyle());
 
         switch (actualStyle) {
             case FormatStyle::STYLE_WITH_BRACKETS:
                 // [YYYY-MM-DD HH:MM:SS] [LOG_LEVEL] message
                 oss << "[";
                 oss << std::put_time(localTime, config.getDateTimeFormat().c_str());
-                oss << "] [" << logLevelToString(record.logLevel) << "] "
-                    << record.message;
+                oss << "] [" << logLevelToString(config, record.logLevel) << "] "
+                    << message;
                 break;
 
             case FormatStyle::STYLE_NO_BRACKETS:
                 // YYYY-MM-DD HH:MM:SS LOG_LEVEL message
                 oss << std::put_time(localTime, config.getDateTimeFormat().c_str()) << " "
-                    << logLevelToString(record.logLevel) << " "
-                    << record.message;
+                    << logLevelToString(config, record.logLevel) << " "
+                    << message;
                 break;
         }
     } else {
         // No timestamp, just level and message
-        oss << "[" << logLevelToString(record.logLevel) << "] " << record.message;
+        oss << "[" << logLevelToString(config, record.logLevel) << "] " << message;
     }
 
     return oss.str();
@@ -0,0 +1,193 @@
+#include "opLog/shm/ShmRing.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+    constexpr std::uint64_t MIN_SLOTS = 64;
+}
+
+std::size_t ShmRing::sizeFor(std::uint64_t slotCount) {
+    return sizeof(Header) + slotCount * sizeof(Slot);
+}
+
+ShmRing::~ShmRing() {
+    if (mapping_) {
+        ::munmap(mapping_, mappingSize_);
+    }
+}
+
+ShmRing* ShmRing::create(const std::string& name, std::uint64_t slotCount) {
+    std::uint64_t slots = MIN_SLOTS;
+    while (slots < slotCount) slots <<= 1;
+
+    // A ring left under our name belongs to a dead process that had our pid
+    ::shm_unlink(name.c_str());
+    const int fd = ::shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR | O_CLOEXEC, 0600);
+    if (fd < 0) {
+        throw std::runtime_error("Cannot create shared memory ring " + name + ": " + std::strerror(errno));
+    }
+
+    const std::size_t size = sizeFor(slots);
+    if (::ftruncate(fd, static_cast<off_t>(size)) != 0) {
+        const int error = errno;
+        ::close(fd);
+        ::shm_unlink(name.c_str());
+        throw std::runtime_error("Cannot size shared memory ring " + name + ": " + std::strerror(error));
+    }
+    void* mapping = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        ::shm_unlink(name.c_str());
+        throw std::runtime_error("Cannot map shared memory ring " + name + ": " + std::strerror(errno));
+    }
+
+    auto* ring = new ShmRing();
+    ring->name_ = name;
+    ring->mapping_ = mapping;
+    ring->mappingSize_ = size;
+    ring->header_ = new (mapping) Header{};
+    ring->slots_ = reinterpret_cast<Slot*>(static_cast<char*>(mapping) + sizeof(Header));
+    ring->mask_ = slots - 1;
+
+    ring->header_->slotCount = slots;
+    ring->header_->pid = ::getpid();
+    for (std::uint64_t i = 0; i < slots; ++i) {
+        new (&ring->slots_[i].sequence) std::atomic<std::uint64_t>(i);
+    }
+    ring->header_->magic.store(kMagic, std::memory_order_release); // Ready for the collector
+    return ring;
+}
+
+ShmRing* ShmRing::attach(const std::string& name) {
+    const int fd = ::shm_open(name.c_str(), O_RDWR | O_CLOEXEC, 0);
+    if (fd < 0) {
+        return nullptr;
+    }
+    struct stat st{};
+    if (::fstat(fd, &st) != 0 || static_cast<std::size_t>(st.st_size) < sizeof(Header)) {
+        ::close(fd);
+        return nullptr;
+    }
+    const auto size = static_cast<std::size_t>(st.st_size);
+    void* mapping = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        return nullptr;
+    }
+
+    auto* header = static_cast<Header*>(mapping);
+    const std::uint64_t slots = header->slotCount;
+    if (header->magic.load(std::memory_order_acquire) != kMagic || slots < MIN_SLOTS ||
+        (slots & (slots - 1)) != 0 || sizeFor(slots) != size) {
+        ::munmap(mapping, size); // Still being created, or not a ring
+        return nullptr;
+    }
+
+    auto* ring = new ShmRing();
+    ring->name_ = name;
+    ring->mapping_ = mapping;
+    ring->mappingSize_ = size;
+    ring->header_ = header;
+    ring->slots_ = reinterpret_cast<Slot*>(static_cast<char*>(mapping) + sizeof(Header));
+    ring->mask_ = slots - 1;
+    return ring;
+}
+
+bool ShmRing::tryWrite(long long timestampNs, LogLevel level, const char* message, std::size_t length) {
+    constexpr std::size_t payloadSize = sizeof(Slot::payload);
+    const std::uint64_t slotCount = mask_ + 1;
+    const std::size_t maxLength = (slotCount / 4) * payloadSize - sizeof(RecordHeader);
+    length = std::min(length, maxLength);
+    const std::uint64_t count = (sizeof(RecordHeader) + length + payloadSize - 1) / payloadSize;
+
+    // Reserve `count` consecutive tickets
+    std::uint64_t ticket = header_->head.load(std::memory_order_relaxed);
+    do {
+        const std::uint64_t tail = header_->tail.load(std::memory_order_acquire);
+        if (ticket + count - tail > slotCount) {
+            header_->dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+    } while (!header_->head.compare_exchange_weak(ticket, ticket + count, std::memory_order_acq_rel,
+                                                  std::memory_order_relaxed));
+
+    const RecordHeader record{timestampNs, static_cast<std::uint32_t>(length), static_cast<std::uint16_t>(count),
+                              static_cast<std::uint8_t>(level), 0};
+    std::memcpy(slots_[ticket & mask_].payload, &record, sizeof(record));
+    std::size_t offset = sizeof(record);
+    std::size_t copied = 0;
+    for (std::uint64_t i = 0; i < count; ++i) {
+        Slot& slot = slots_[(ticket + i) & mask_];
+        const std::size_t chunk = std::min(length - copied, payloadSize - offset);
+        std::memcpy(slot.payload + offset, message + copied, chunk);
+        copied += chunk;
+        offset = 0;
+    }
+
+    // Publish the first slot last: once it is visible, the rest are too
+    for (std::uint64_t i = count; i-- > 0;) {
+        slots_[(ticket + i) & mask_].sequence.store(ticket + i + 1, std::memory_order_release);
+    }
+    return true;
+}
+
+ShmRing::ReadResult ShmRing::tryRead(Record& out) {
+    constexpr std::size_t payloadSize = sizeof(Slot::payload);
+    const std::uint64_t slotCount = mask_ + 1;
+    const std::uint64_t ticket = header_->tail.load(std::memory_order_relaxed);
+    if (ticket == header_->head.load(std::memory_order_acquire)) {
+        return ReadResult::EMPTY;
+    }
+
+    Slot& first = slots_[ticket & mask_];
+    if (first.sequence.load(std::memory_order_acquire) != ticket + 1) {
+        return ReadResult::PENDING;
+    }
+
+    RecordHeader record;
+    std::memcpy(&record, first.payload, sizeof(record));
+    std::uint64_t count = record.slots;
+    const bool valid = count >= 1 && count <= slotCount / 4 && record.level <= static_cast<std::uint8_t>(LogLevel::FATAL) &&
+                       sizeof(record) + record.length <= count * payloadSize;
+    if (!valid) {
+        count = 1; // Never trust a bad header: drop this slot and move on
+        header_->dropped.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        for (std::uint64_t i = 1; i < count; ++i) {
+            if (slots_[(ticket + i) & mask_].sequence.load(std::memory_order_acquire) != ticket + i + 1) {
+                return ReadResult::PENDING;
+            }
+        }
+
+        out.timestampNs = record.timestampNs;
+        out.level = static_cast<LogLevel>(record.level);
+        out.message.resize(record.length);
+        std::size_t offset = sizeof(record);
+        std::size_t copied = 0;
+        for (std::uint64_t i = 0; i < count; ++i) {
+            const Slot& slot = slots_[(ticket + i) & mask_];
+            const std::size_t chunk = std::min<std::size_t>(record.length - copied, payloadSize - offset);
+            std::memcpy(out.message.data() + copied, slot.payload + offset, chunk);
+            copied += chunk;
+            offset = 0;
+        }
+    }
+
+    // Hand the slots to the next lap, then let producers reuse them
+    for (std::uint64_t i = 0; i < count; ++i) {
+        slots_[(ticket + i) & mask_].sequence.store(ticket + i + slotCount, std::memory_order_relaxed);
+    }
+    header_->tail.store(ticket + count, std::memory_order_release);
+    return valid ? ReadResult::RECORD : tryRead(out);
+}
+
+void ShmRing::unlink() {
+    ::shm_unlink(name_.c_str());
+}
@@ -1,6 +1,31 @@
 #include<iostream>
+#include <cstring>
+#include <filesystem>
+#include <random>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+#include <poll.h>
+#include <fstream>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "opLog/Config.h"
+#include "opLog/Payload.h"
+#include "opLog/appender/CompressedFileAppender.h"
 #include "opLog/appender/ConsoleAppender.h"
 #include "opLog/appender/FileAppender.h"
+#include "opLog/appender/IoUringFileAppender.h"
+#include "opLog/appender/RotationWorker.h"
+#include "opLog/appender/ShardedFileAppender.h"
+#include "opLog/appender/TimeIndex.h"
+#include "opLog/appender/UnixSocketAppender.h"
+#include "opLog/formatter/PlainTextFormatter.h"
+#include "opLog/compression/Compressor.h"
+#ifdef OPLOG_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+namespace fs = std::filesystem;
 
 void unitConsoleAppender() {
     ConsoleAppender appender;
@@ -8,7 +33,59 @@ void unitConsoleAppender() {
     appender.write("2025-09-13 20:11:36 WARN this is a debug message");
 }
 
+bool unitConsoleAppenderPiped() {
+    auto& config = opLog::Config::getInstance();
+    config.setConsoleSplitStderr(true);
+
+    // Point fd 1 and fd 2 at pipes so the appender sees non-terminals
+    int outPipe[2], errPipe[2];
+    if (::pipe(outPipe) != 0 || ::pipe(errPipe) != 0) return false;
+    std::cout.flush();
+    const int savedOut = ::dup(STDOUT_FILENO);
+    const int savedErr = ::dup(STDERR_FILENO);
+    ::dup2(outPipe[1], STDOUT_FILENO);
+    ::dup2(errPipe[1], STDERR_FILENO);
+
+    char out[128]{}, err[128]{}, held[128]{};
+    {
+        ConsoleAppender appender;
+        appender.write({LogLevel::INFO, "", {}}, "[\033[32mINFO\033[0m] to stdout");
+        appender.write({LogLevel::ERROR, "", {}}, "[\033[31mERROR\033[0m] to stderr");
+    }
+    bool ok = ::read(outPipe[0], out, sizeof(out) - 1) > 0 &&
+              ::read(errPipe[0], err, sizeof(err) - 1) > 0 &&
+              std::string(out) == "[INFO] to stdout\n" &&
+              std::string(err) == "[ERROR] to stderr\n";
+
+    // Without auto_flush a quiet appender still writes within the interval
+    config.setAutoFlushEnabled(false);
+    config.setConsoleFlushIntervalMs(50);
+    {
+        ConsoleAppender appender;
+        appender.write({LogLevel::INFO, "", {}}, "held back");
+        pollfd pfd{outPipe[0], POLLIN, 0};
+        ok = ok && ::poll(&pfd, 1, 0) == 0; // Buffered at first
+        ok = ok && ::poll(&pfd, 1, 2000) == 1 && ::read(outPipe[0], held, sizeof(held) - 1) > 0 &&
+             std::string(held) == "held back\n";
+    }
+    config.setAutoFlushEnabled(true);
+    config.setConsoleFlushIntervalMs(200);
+
+    ::dup2(savedOut, STDOUT_FILENO);
+    ::dup2(savedErr, STDERR_FILENO);
+    for (const int fd : {savedOut, savedErr, outPipe[0], outPipe[1], errPipe[0], errPipe[1]}) {
+        ::close(fd);
+    }
+    config.setConsoleSplitStderr(false);
+
+    std::cout << "Console appender piped: " << (ok ? "OK" : "FAILED") << std::endl;
+    return ok;
+}
+
 void unitFileAppender() {
+    const fs::path dir = fs::temp_directory_path() / "oplog-test-file";
+    fs::remove_all(dir);
+    opLog::Config::getInstance().setLogDirectory(dir.string());
     try {
         FileAppender appender;
         appender.write("[2024-01-15] Test message 1");
@@ -18,6 +95,567 @@ void unitFileAppender() {
     } catch (const std::exception& e) {
         std::cout << "Error: " << e.what() << std::endl;
     }
+    fs::remove_all(dir);
+}
+
+LogRecord recordAt(int year, int month, int day, int hour, const std::string& message) {
+    std::tm local{};
+    local.tm_year = year - 1900;
+    local.tm_mon = month - 1;
+    local.tm_mday = day;
+    local.tm_hour = hour;
+    local.tm_isdst = -1;
+    return {LogLevel::INFO, message, std::chrono::system_clock::from_time_t(std::mktime(&local))};
+}
+
+bool unitFileRotation() {
+    const fs::path dir = fs::temp_directory_path() / "oplog-test-rotation";
+    fs::remove_all(dir);
+
+    auto& config = opLog::Config::getInstance();
+    config.setLogDirectory(dir.string());
+    config.setRotationInterval(3600);
+    config.setMaxFileSize(64);
+    config.setMaxBackupFiles(2);
+
+    // Timestamps drive the file name, whatever the formatted text looks like
+    {
+        FileAppender appender;
+        const std::string line(40, 'x');
+        appender.write(recordAt(2024, 1, 15, 10, "a"), line);
+        appender.write(recordAt(2024, 1, 15, 10, "b"), line); // reaches 64 bytes
+        appender.write(recordAt(2024, 1, 15, 10, "c"), line); // size rotation
+        appender.write(recordAt(2024, 1, 15, 10, "d"), line);
+        appender.write(recordAt(2024, 1, 15, 10, "e"), line); // size rotation
+        appender.write(recordAt(2024, 1, 15, 10, "f"), line);
+        appender.write(recordAt(2024, 1, 15, 10, "g"), line); // size rotation, .3 dropped
+        appender.write(recordAt(2024, 1, 15, 11, "h"), line); // hourly rotation
+    }
+
+    // A rotation interrupted by a crash is finished on startup
+    std::ofstream(dir / "2024-01-15-11-log.pending-1.txt") << "leftover\n";
+    { FileAppender recovered; }
+    RotationWorker::getInstance().drain();
+
+    const bool ok = fs::exists(dir / "2024-01-15-10-log.txt") &&
+                    fs::exists(dir / "2024-01-15-10-log.1.txt") &&
+                    fs::exists(dir / "2024-01-15-10-log.2.txt") &&
+                    !fs::exists(dir / "2024-01-15-10-log.3.txt") &&
+                    fs::exists(dir / "2024-01-15-11-log.txt") &&
+                    fs::exists(dir / "2024-01-15-11-log.1.txt") &&
+                    !fs::exists(dir / "2024-01-15-11-log.pending-1.txt");
+    std::cout << "File rotation: " << (ok ? "OK" : "FAILED") << std::endl;
+    fs::remove_all(dir);
+    return ok;
+}
+
+// Setters called while a FileAppender is open apply from its next record
+bool unitFileSettingsChange() {
+    const fs::path dir = fs::temp_directory_path() / "oplog-test-settings";
+    fs::remove_all(dir);
+    const auto linesIn = [](const fs::path& file) {
+        std::vector<std::string> lines;
+        std::ifstream in(file);
+        for (std::string line; std::getline(in, line);) lines.push_back(line);
+        return lines;
+    };
+
+    auto& config = opLog::Config::getInstance();
+    config.setLogDirectory((dir / "first").string());
+    config.setRotationInterval(3600);
+    config.setMaxFileSize(100 * 1024 * 1024);
+    config.setAutoFlushEnabled(true);
+
+    const fs::path first = dir / "first" / "2024-01-15-10-log.txt";
+    const fs::path second = dir / "second" / "2024-01-15-10-log.txt";
+    bool ok;
+    {
+        FileAppender appender;
+        appender.write(recordAt(2024, 1, 15, 10, ""), "one");
+        config.setLogDirectory((dir / "second").string());
+        appender.write(recordAt(2024, 1, 15, 10, ""), "two");
+        ok = linesIn(first) == std::vector<std::string>{"one"} && linesIn(second) == std::vector<std::string>{"two"};
+
+        config.setAutoFlushEnabled(false);
+        appender.write(recordAt(2024, 1, 15, 10, ""), "three");
+        ok = ok && linesIn(second).size() == 1;
+        config.setAutoFlushEnabled(true);
+        appender.write(recordAt(2024, 1, 15, 10, ""), "four");
+        ok = ok && linesIn(second) == std::vector<std::string>{"two", "three", "four"};
+    }
+    std::cout << "File settings change: " << (ok ? "OK" : "FAILED") << std::endl;
+    fs::remove_all(dir);
+    return ok;
+}
+
+bool unitRotationCompression() {
+    if (!Compressor::isAvailable(CompressionCodec::GZIP)) {
+        std::cout << "Rotation compression: skipped (no zlib)" << std::endl;
+        return true;
+    }
+
+    const fs::path dir = fs::temp_directory_path() / "oplog-test-compression";
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+
+    auto& config = opLog::Config::getInstance();
+    config.setLogDirectory(dir.string());
+    config.setRotationInterval(3600);
+    config.setMaxFileSize(64);
+    config.setMaxBackupFiles(3);
+    config.setCompressRotated(CompressionCodec::GZIP);
+
+    // State left by a crash mid-compression: valid original plus partial temp
+    std::ofstream(dir / "2024-01-15-10-log.2.txt") << "older generation\n";
+    std::ofstream(dir / "2024-01-15-10-log.2.txt.gz.tmp") << "partial";
+    // Someone else's temp files are left alone
+    std::ofstream(dir / "upload.tmp") << "not ours";
+    std::ofstream(dir / "2024-01-15-10-log.9.txt.gz.tmp") << "no original";
+
+    {
+        FileAppender appender;
+        const std::string line(40, 'x');
+        for (const char* message : {"a", "b", "c", "d"}) {
+            appender.write(recordAt(2024, 1, 15, 10, message), line);
+        }
+    }
+    RotationWorker::getInstance().drain();
+    config.setCompressRotated(CompressionCodec::NONE);
+
+    // The recovered .2 is compressed, then shifted to .3 by the rotation
+    const bool ok = fs::exists(dir / "2024-01-15-10-log.txt") &&
+                    fs::exists(dir / "2024-01-15-10-log.1.txt.gz") &&
+                    fs::exists(dir / "2024-01-15-10-log.3.txt.gz") &&
+                    !fs::exists(dir / "2024-01-15-10-log.1.txt") &&
+                    !fs::exists(dir / "2024-01-15-10-log.2.txt") &&
+                    !fs::exists(dir / "2024-01-15-10-log.2.txt.gz") &&
+                    !fs::exists(dir / "2024-01-15-10-log.2.txt.gz.tmp") &&
+                    fs::exists(dir / "upload.tmp") &&
+                    fs::exists(dir / "2024-01-15-10-log.9.txt.gz.tmp");
+    std::cout << "Rotation compression: " << (ok ? "OK" : "FAILED") << std::endl;
+    fs::remove_all(dir);
+    return ok;
+}
+
+#ifdef OPLOG_HAVE_ZLIB
+// What a reader gets out of concatenated gzip members: the text of every
+// complete member, stopping at one that is cut short or damaged
+std::string gunzipMembers(const std::string& data) {
+    std::string text;
+    z_stream stream{};
+    if (inflateInit2(&stream, 16 + MAX_WBITS) != Z_OK) {
+        return text;
+    }
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+    stream.avail_in = static_cast<uInt>(data.size());
+    std::string member;
+    char out[16384];
+    while (stream.avail_in > 0) {
+        stream.next_out = reinterpret_cast<Bytef*>(out);
+        stream.avail_out = sizeof(out);
+        const int status = inflate(&stream, Z_NO_FLUSH);
+        member.append(out, sizeof(out) - stream.avail_out);
+        if (status == Z_STREAM_END) {
+            text += member;
+            member.clear();
+            inflateReset(&stream);
+        } else if (status != Z_OK) {
+            break;
+        }
+    }
+    inflateEnd(&stream);
+    return text;
+}
+#endif
+
+bool unitCompressedFileAppender() {
+#ifndef OPLOG_HAVE_ZLIB
+    std::cout << "Compressed appender: skipped (no zlib)" << std::endl;
+    return true;
+#else
+
+    const fs::path dir = fs::temp_directory_path() / "oplog-test-compressed";
+    fs::remove_all(dir);
+
+    auto& config = opLog::Config::getInstance();
+    config.setLogDirectory(dir.string());
+    config.setRotationInterval(86400);
+    config.setMaxFileSize(10 * 1024 * 1024);
+    config.setStreamCompression(CompressionCodec::GZIP);
+    config.setCompressionFrameSize(1024);
+
+    std::string plain;
+    {
+        CompressedFileAppender appender;
+        for (int i = 0; i < 1000; ++i) {
+            const std::string line = "[2024-01-15 10:00:00] [INFO] request " + std::to_string(i);
+            appender.write(recordAt(2024, 1, 15, 10, line), line);
+            plain += line + '\n';
+        }
+    }
+
+    // The whole file decompresses to exactly the lines written
+    const fs::path file = dir / "2024-01-15-log.txt.gz";
+    const auto readFile = [&] {
+        std::ifstream in(file, std::ios::binary);
+        return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    };
+    const std::string compressed = readFile();
+    bool ok = compressed.size() < plain.size() / 2 && gunzipMembers(compressed) == plain;
+
+    // Cut off in the middle of a frame, as by a crash: every frame before the
+    // cut still decompresses, and holds whole lines only
+    fs::resize_file(file, compressed.size() / 2);
+    const std::string recovered = gunzipMembers(readFile());
+    ok = ok && !recovered.empty() && recovered.back() == '\n' &&
+         plain.compare(0, recovered.size(), recovered) == 0 &&
+         recovered.size() + 2 * 1024 >= plain.size() / 2 && recovered.size() < plain.size();
+    std::cout << "Compressed appender: " << (ok ? "OK" : "FAILED") << std::endl;
+    fs::remove_all(dir);
+    return ok;
+#endif
+}
+
+// Descriptors this process holds on files in `dir`
+size_t openFilesIn(const fs::path& dir) {
+    size_t count = 0;
+    std::error_code ec;
+    for (const auto& entry : fs::directory_iterator("/proc/self/fd", ec)) {
+        const fs::path target = fs::read_symlink(entry.path(), ec);
+        if (!ec && target.parent_path() == dir) ++count;
+    }
+    return count;
+}
+
+bool unitShardedFileAppender() {
+    const fs::path dir = fs::temp_directory_path() / "oplog-test-sharded";
+    fs::remove_all(dir);
+
+    auto& config = opLog::Config::getInstance();
+    config.setLogDirectory(dir.string());
+    config.setRotationInterval(86400);
+    config.setMaxFileSize(10 * 1024 * 1024);
+
+    bool closedOk = false;
+    {
+        ShardedFileAppender appender;
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 4; ++t) {
+            threads.emplace_back([&appender, t] {
+                for (int i = 0; i < 100; ++i) {
+                    appender.write(recordAt(2024, 1, 15, 10, ""), "thread " + std::to_string(t));
+                }
+            });
+        }
+        for (auto& thread : threads) thread.join();
+
+        // The writers have exited: their shards are written out and closed
+        appender.flush();
+        closedOk = openFilesIn(dir) == 0;
+        appender.write(recordAt(2024, 1, 15, 10, ""), "main thread");
+        closedOk = closedOk && openFilesIn(dir) == 1;
+    }
+
+    size_t shards = 0;
+    size_t lines = 0;
+    bool prefixed = true;
+    for (const auto& entry : fs::directory_iterator(dir)) {
+        ++shards;
+        std::ifstream in(entry.path());
+        std::string line;
+        while (std::getline(in, line)) {
+            ++lines;
+            prefixed = prefixed && line.size() > ShardedFileAppender::kTimestampPrefix &&
+                       line[ShardedFileAppender::kTimestampPrefix - 1] == ' ';
+        }
+    }
+
+    const bool ok = shards == 5 && lines == 401 && prefixed && closedOk;
+    std::cout << "Sharded appender: " << (ok ? "OK" : "FAILED") << std::endl;
+    fs::remove_all(dir);
+    return ok;
+}
+
+bool unitTimeIndex() {
+    const fs::path dir = fs::temp_directory_path() / "oplog-test-index";
+    fs::remove_all(dir);
+
+    auto& config = opLog::Config::getInstance();
+    config.setLogDirectory(dir.string());
+    config.setRotationInterval(86400);
+    config.setMaxFileSize(10 * 1024 * 1024);
+    config.setTimeIndexEnabled(true);
+    config.setTimeIndexRecords(10);
+
+    PlainTextFormatter formatter;
+    auto writeRecords = [&](int first, int count) {
+        FileAppender appender;
+        for (int i = first; i < first + count; ++i) {
+            LogRecord record = recordAt(2024, 1, 15, 10, "record " + std::to_string(i));
+            record.timestamp += std::chrono::seconds(i);
+            appender.write(record, formatter.format(record));
+        }
+    };
+
+    const fs::path log = dir / "2024-01-15-log.txt";
+    const std::string index = log.string() + TimeIndex::kSuffix;
+
+    writeRecords(0, 100);
+    const auto written = TimeIndex::load(index, fs::file_size(log));
+
+    // A lost index is rebuilt from the log text when the file is reopened
+    fs::remove(index);
+    writeRecords(100, 1);
+    const auto rebuilt = TimeIndex::load(index, fs::file_size(log));
+    config.setTimeIndexEnabled(false);
+
+    const bool ok = written.size() == 10 && written.front().offset == 0 &&
+                    written[1].timestampNs - written[0].timestampNs == 10'000'000'000LL &&
+                    rebuilt.size() >= 10 && rebuilt[3].offset == written[3].offset;
+    std::cout << "Time index: " << (ok ? "OK" : "FAILED") << std::endl;
+    fs::remove_all(dir);
+    return ok;
+}
+
+// Stands in for the local log agent
+int bindAgent(const std::string& path, int type) {
+    ::unlink(path.c_str());
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    std::strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+    const int fd = ::socket(AF_UNIX, type, 0);
+    ::bind(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address));
+    if (type == SOCK_STREAM) ::listen(fd, 1);
+    const timeval timeout{2, 0};
+    ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    return fd;
+}
+
+bool unitUnixSocketAppender() {
+    const std::string path = (fs::temp_directory_path() / ("oplog-test-agent-" + std::to_string(::getpid()))).string();
+    auto& config = opLog::Config::getInstance();
+    config.setSocketPath(path);
+    config.setSocketBufferBytes(1024 * 1024);
+    char buffer[4096];
+
+    // Datagrams: one record per datagram, in order
+    config.setSocketStream(false);
+    int agent = bindAgent(path, SOCK_DGRAM);
+    bool dgramOk = true;
+    {
+        UnixSocketAppender appender;
+        for (int i = 0; i < 500; ++i) appender.write("record " + std::to_string(i));
+        for (int i = 0; i < 500 && dgramOk; ++i) {
+            const ssize_t n = ::recv(agent, buffer, sizeof(buffer), 0);
+            dgramOk = n > 0 && std::string(buffer, static_cast<size_t>(n)) == "record " + std::to_string(i);
+        }
+    }
+    ::close(agent);
+
+    // Agent down: records are held, then delivered once it comes up
+    ::unlink(path.c_str());
+    bool spillOk = true;
+    {
+        UnixSocketAppender appender;
+        for (int i = 0; i < 10; ++i) appender.write("held " + std::to_string(i));
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        agent = bindAgent(path, SOCK_DGRAM);
+        for (int i = 0; i < 10 && spillOk; ++i) {
+            const ssize_t n = ::recv(agent, buffer, sizeof(buffer), 0);
+            spillOk = n > 0 && std::string(buffer, static_cast<size_t>(n)) == "held " + std::to_string(i);
+        }
+        spillOk = spillOk && appender.droppedRecords() == 0;
+    }
+    ::close(agent);
+
+    // Stream: newline-terminated records over one connection
+    config.setSocketStream(true);
+    agent = bindAgent(path, SOCK_STREAM);
+    std::string received;
+    std::thread reader([&] {
+        const int connection = ::accept(agent, nullptr, nullptr);
+        ssize_t n;
+        while ((n = ::recv(connection, buffer, sizeof(buffer), 0)) > 0) received.append(buffer, static_cast<size_t>(n));
+        ::close(connection);
+    });
+    std::string expected;
+    {
+        UnixSocketAppender appender;
+        for (int i = 0; i < 2000; ++i) {
+            appender.write("line " + std::to_string(i));
+            expected += "line " + std::to_string(i) + "\n";
+        }
+    }
+    reader.join();
+    ::close(agent);
+    const bool streamOk = received == expected;
+
+    // Bounded buffer: with no agent, records past socket_buffer_bytes are dropped
+    ::unlink(path.c_str());
+    config.setSocketBufferBytes(100);
+    bool boundedOk;
+    {
+        UnixSocketAppender appender;
+        for (int i = 0; i < 20; ++i) appender.write("0123456789");
+        boundedOk = appender.droppedRecords() >= 10;
+    }
+
+    const bool ok = dgramOk && spillOk && streamOk && boundedOk;
+    std::cout << "Unix socket appender: " << (ok ? "OK" : "FAILED") << std::endl;
+    ::unlink(path.c_str());
+    return ok;
+}
+
+// Records written through io_uring across many size rotations come back
+// complete and in order
+bool unitIoUringFileAppender() {
+    const fs::path dir = fs::temp_directory_path() / "oplog-test-uring";
+    fs::remove_all(dir);
+
+    auto& config = opLog::Config::getInstance();
+    config.setLogDirectory(dir.string());
+    config.setRotationInterval(3600);
+    config.setMaxFileSize(16 * 1024);
+    config.setMaxBackupFiles(1000);
+    config.setAutoFlushEnabled(false);
+    config.setIoUringBuffers(2); // Make the writer wait on completions
+
+    constexpr int RECORDS = 20000;
+    bool usedRing;
+    {
+        IoUringFileAppender appender;
+        usedRing = appender.usingIoUring();
+        for (int i = 0; i < RECORDS; ++i) {
+            appender.write(recordAt(2024, 1, 15, 10, ""), "line " + std::to_string(i));
+            if (i == RECORDS / 2) appender.flush();
+        }
+    }
+    RotationWorker::getInstance().drain();
+
+    // Oldest backup has the highest number
+    std::vector<fs::path> files;
+    for (int n = 1; fs::exists(dir / ("2024-01-15-10-log." + std::to_string(n) + ".txt")); ++n) {
+        files.insert(files.begin(), dir / ("2024-01-15-10-log." + std::to_string(n) + ".txt"));
+    }
+    files.push_back(dir / "2024-01-15-10-log.txt");
+
+    int next = 0;
+    bool ordered = files.size() > 10;
+    for (const auto& file : files) {
+        std::ifstream in(file);
+        for (std::string line; ordered && std::getline(in, line); ++next) {
+            ordered = line == "line " + std::to_string(next);
+        }
+    }
+
+    config.setMaxFileSize(10 * 1024 * 1024);
+    config.setMaxBackupFiles(5);
+    config.setAutoFlushEnabled(true);
+    config.setIoUringBuffers(8);
+    const bool ok = ordered && next == RECORDS;
+    std::cout << "io_uring file appender" << (usedRing ? "" : " (pwrite fallback)") << ": "
+              << (ok ? "OK" : "FAILED") << std::endl;
+    fs::remove_all(dir);
+    return ok;
+}
+
+bool unitPayloadEncoding() {
+    const char* digits = "0123456789abcdef";
+    const char* alphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    std::mt19937 rng(42);
+    std::vector<size_t> sizes;
+    for (size_t n = 0; n <= 100; ++n) sizes.push_back(n);
+    sizes.push_back(4096 + 7);
+    sizes.push_back(300000);
+
+    bool ok = true;
+    for (const size_t size : sizes) {
+        std::vector<unsigned char> bytes(size);
+        for (auto& byte : bytes) byte = static_cast<unsigned char>(rng());
+
+        std::string hex;
+        for (const unsigned char byte : bytes) {
+            hex += digits[byte >> 4];
+            hex += digits[byte & 0x0f];
+        }
+        std::string base64;
+        for (size_t i = 0; i < size; i += 3) {
+            const unsigned triple = (bytes[i] << 16) | (i + 1 < size ? bytes[i + 1] << 8 : 0) |
+                                    (i + 2 < size ? bytes[i + 2] : 0);
+            base64 += alphabet[(triple >> 18) & 0x3f];
+            base64 += alphabet[(triple >> 12) & 0x3f];
+            base64 += i + 1 < size ? alphabet[(triple >> 6) & 0x3f] : '=';
+            base64 += i + 2 < size ? alphabet[triple & 0x3f] : '=';
+        }
+
+        // One guard byte past the end catches overruns
+        std::string out(2 * size + 1, '#');
+        Payload::encodeHex(bytes.data(), size, out.data());
+        ok = ok && out == hex + "#";
+        out.assign(Payload::base64Size(size) + 1, '#');
+        Payload::encodeBase64(bytes.data(), size, out.data());
+        ok = ok && out == base64 + "#";
+    }
+
+    std::string line = "head";
+    Payload::borrow("\x01\xab\xff", 3).truncate(2).appendTo(line);
+    ok = ok && line == "head 01ab (+1 bytes)";
+
+    std::cout << "Payload encoding: " << (ok ? "OK" : "FAILED") << std::endl;
+    return ok;
+}
+
+// A payload goes into the file right after its line, also when it is large
+// enough to be written separately from the buffer
+template<typename Appender>
+bool checkPayloadFile(const std::string& name, bool autoFlush) {
+    const fs::path dir = fs::temp_directory_path() / ("oplog-test-payload-" + name);
+    fs::remove_all(dir);
+
+    auto& config = opLog::Config::getInstance();
+    config.setLogDirectory(dir.string());
+    config.setRotationInterval(3600);
+    config.setAutoFlushEnabled(autoFlush);
+
+    std::string body(200000, 'x');
+    for (size_t i = 0; i < body.size(); i += 97) body[i] = static_cast<char>('a' + i % 26);
+    const unsigned char small[] = {0xde, 0xad, 0xbe, 0xef};
+
+    {
+        Appender appender;
+        LogRecord record = recordAt(2024, 1, 15, 10, "");
+        appender.write(record, "before");
+        record.payload = Payload::borrow(small, sizeof(small));
+        appender.write(record, "small");
+        record.payload = Payload::borrow(body.data(), body.size(), Payload::Encoding::RAW);
+        appender.write(record, "raw");
+        record.payload = Payload::share(std::make_shared<const std::string>(body), Payload::Encoding::BASE64);
+        record.payload.truncate(90000);
+        appender.write(record, "base64");
+        record.payload = Payload();
+        appender.write(record, "after");
+    }
+
+    std::string base64(Payload::base64Size(90000), ' ');
+    Payload::encodeBase64(reinterpret_cast<const unsigned char*>(body.data()), 90000, base64.data());
+    const std::vector<std::string> expected = {
+        "before", "small deadbeef", "raw " + body, "base64 " + base64 + " (+110000 bytes)", "after"};
+
+    std::ifstream in(dir / "2024-01-15-10-log.txt");
+    std::vector<std::string> lines;
+    for (std::string line; std::getline(in, line);) lines.push_back(line);
+
+    config.setAutoFlushEnabled(true);
+    fs::remove_all(dir);
+    return lines == expected;
+}
+
+bool unitPayloadAppenders() {
+    const bool ok = checkPayloadFile<FileAppender>("file", true) &&
+                    checkPayloadFile<FileAppender>("buffered", false) &&
+                    checkPayloadFile<IoUringFileAppender>("uring", false);
+    std::cout << "Payload appenders: " << (ok ? "OK" : "FAILED") << std::endl;
+    return ok;
 }
 
 int main() {
@@ -25,5 +663,16 @@ int main() {
     unitConsoleAppender();
     unitFileAppender();
 
-    return 0;
-}
\ No newline at end of file
+    bool ok = unitConsoleAppenderPiped();
+    ok = unitFileRotation() && ok;
+    ok = unitFileSettingsChange() && ok;
+    ok = unitRotationCompression() && ok;
+    ok = unitCompressedFileAppender() && ok;
+    ok = unitShardedFileAppender() && ok;
+    ok = unitTimeIndex() && ok;
+    ok = unitUnixSocketAppender() && ok;
+    ok = unitIoUringFileAppender() && ok;
+    ok = unitPayloadEncoding() && ok;
+    ok = unitPayloadAppenders() && ok;
+    return ok ? 0 : 1;
+}
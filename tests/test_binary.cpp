@@ -0,0 +1,95 @@
+#include <filesystem>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include "opLog/Config.h"
+#include "opLog/appender/BinaryFileAppender.h"
+#include "opLog/binary/BinaryLogReader.h"
+
+namespace fs = std::filesystem;
+
+struct Decoded {
+    long long timestampNs;
+    LogLevel level;
+    std::string message;
+};
+
+int main() {
+    const fs::path dir = fs::temp_directory_path() / "oplog-test-binary";
+    fs::remove_all(dir);
+
+    auto& config = opLog::Config::getInstance();
+    config.setLogDirectory(dir.string());
+    config.setRotationInterval(0);
+    config.setBinaryBlockRecords(100);
+
+    // 1000 records, 1 ms apart, every 10th one an ERROR, few distinct messages
+    const auto start = std::chrono::system_clock::now();
+    {
+        BinaryFileAppender appender;
+        for (int i = 0; i < 1000; ++i) {
+            const LogLevel level = i % 10 == 0 ? LogLevel::ERROR : LogLevel::INFO;
+            const LogRecord record{level, "message " + std::to_string(i % 7), start + std::chrono::milliseconds(i)};
+            appender.write(record, "");
+        }
+    }
+
+    const fs::path file = *fs::directory_iterator(dir);
+    BinaryLogReader reader(file.string());
+
+    std::vector<Decoded> all;
+    reader.read({}, [&](long long timestampNs, LogLevel level, std::string_view message) {
+        all.push_back({timestampNs, level, std::string(message)});
+    });
+
+    bool ok = reader.blocks().size() == 10 && !reader.isTruncated() && all.size() == 1000;
+    for (size_t i = 0; ok && i < all.size(); ++i) {
+        const auto expected = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            (start + std::chrono::milliseconds(i)).time_since_epoch()).count();
+        ok = all[i].timestampNs == expected && all[i].message == "message " + std::to_string(i % 7) &&
+             all[i].level == (i % 10 == 0 ? LogLevel::ERROR : LogLevel::INFO);
+    }
+    std::cout << "Round trip: " << (ok ? "OK" : "FAILED") << std::endl;
+
+    // A time window only decodes the blocks it overlaps
+    BinaryLogReader::Filter window;
+    window.fromNs = all[250].timestampNs;
+    window.toNs = all[349].timestampNs;
+    window.minLevel = LogLevel::ERROR;
+    size_t matched = 0;
+    const size_t decoded = reader.read(window, [&](long long, LogLevel, std::string_view) { ++matched; });
+    const bool windowOk = matched == 10 && decoded == 2;
+    std::cout << "Block skipping: " << (windowOk ? "OK" : "FAILED") << std::endl;
+
+    // A torn last block is ignored
+    fs::resize_file(file, fs::file_size(file) - 5);
+    BinaryLogReader torn(file.string());
+    const bool tornOk = torn.blocks().size() == 9 && torn.isTruncated();
+    std::cout << "Truncated tail: " << (tornOk ? "OK" : "FAILED") << std::endl;
+
+    // A quiet appender closes its open block once it is old enough, even
+    // without auto_flush
+    fs::remove_all(dir);
+    config.setAutoFlushEnabled(false);
+    config.setBinaryBlockRecords(4096);
+    config.setBinaryBlockIntervalMs(50);
+    bool agedOk = false;
+    {
+        BinaryFileAppender appender;
+        for (int i = 0; i < 5; ++i) {
+            appender.write(LogRecord{LogLevel::INFO, "quiet", std::chrono::system_clock::now()}, "");
+        }
+        for (int i = 0; i < 200 && !agedOk; ++i) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            const fs::path aged = *fs::directory_iterator(dir);
+            BinaryLogReader reader(aged.string());
+            agedOk = reader.blocks().size() == 1 && reader.blocks()[0].recordCount == 5;
+        }
+    }
+    config.setAutoFlushEnabled(true);
+    config.setBinaryBlockIntervalMs(1000);
+    std::cout << "Block age: " << (agedOk ? "OK" : "FAILED") << std::endl;
+
+    fs::remove_all(dir);
+    return ok && windowOk && tornOk && agedOk ? 0 : 1;
+}
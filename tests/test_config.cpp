@@ -1,7 +1,17 @@
 #include "opLog/Config.h"
+#include "opLog/ConfigWatcher.h"
+#include "opLog/Logger.h"
 #include "opLog/appender/FileAppender.h"
 #include "opLog/formatter/PlainTextFormatter.h"
+#include <atomic>
+#include <filesystem>
+#include <fstream>
 #include <iostream>
+#include <thread>
+
+namespace fs = std::filesystem;
+
+bool unitConfigWatcher();
 
 int main() {
     try {
@@ -109,6 +119,9 @@ int main() {
         config.reloadConfig();
         config.printCurrentConfig();
 
+        if (!unitConfigWatcher()) {
+            return 1;
+        }
         std::cout << "\nConfiguration test completed successfully!" << std::endl;
 
     } catch (const std::exception& e) {
@@ -143,4 +156,87 @@ void createCustomConfig() {
 
     // Save this configuration
     config.saveConfig("production-oplog.conf");
-}
\ No newline at end of file
+}
+// Edits to a watched file are applied once they settle, bad files are
+// rejected, and a logger writing throughout loses nothing
+bool unitConfigWatcher() {
+    const fs::path dir = fs::temp_directory_path() / "oplog-test-watch";
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+    const fs::path path = dir / "opLog.conf";
+
+    const auto writeConfig = [&](const std::string& level, const std::string& extra, bool rename) {
+        const fs::path target = rename ? dir / "opLog.conf.tmp" : path;
+        std::ofstream(target) << "log_directory=" << (dir / "logs").string() << "\n"
+                              << "watch_config=true\nwatch_debounce_ms=100\n"
+                              << "enable_timestamp=false\nenable_colors=false\n"
+                              << "min_log_level=" << level << "\n" << extra;
+        if (rename) fs::rename(target, path);
+    };
+    auto& watcher = ConfigWatcher::getInstance();
+    const auto waitForReloads = [&](std::uint64_t count) {
+        for (int i = 0; i < 300 && watcher.appliedReloads() + watcher.rejectedReloads() < count; ++i) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(150)); // Nothing more follows
+        return watcher.appliedReloads() + watcher.rejectedReloads();
+    };
+
+    // At startup a line that does not parse is skipped, not the whole file
+    auto& earlier = opLog::Config::getInstance();
+    writeConfig("INFO", "max_file_size=lots\n", false);
+    opLog::Config::initialize(path.string());
+    bool ok = watcher.isRunning() && opLog::Config::getInstance().getMinLogLevel() == LogLevel::INFO;
+
+    constexpr int RECORDS = 20000;
+    std::atomic<int> written{0};
+    {
+        std::vector<std::unique_ptr<IAppender>> appenders;
+        appenders.push_back(std::make_unique<FileAppender>());
+        Logger logger(nullptr, std::move(appenders));
+        std::thread writer([&] {
+            for (int i = 0; i < RECORDS; ++i) {
+                logger.warn("record " + std::to_string(i));
+                written.store(i + 1, std::memory_order_relaxed);
+            }
+        });
+
+        // A burst of saves is one reload
+        const std::uint64_t before = watcher.appliedReloads();
+        for (int i = 0; i < 5; ++i) writeConfig("DEBUG", "", i % 2 == 0);
+        waitForReloads(before + 1);
+        ok = ok && watcher.appliedReloads() == before + 1 &&
+             opLog::Config::getInstance().getMinLogLevel() == LogLevel::DEBUG;
+
+        // A file that does not parse changes nothing
+        writeConfig("ERROR", "max_file_size=lots\n", true);
+        waitForReloads(before + 2);
+        ok = ok && watcher.rejectedReloads() == 1 &&
+             opLog::Config::getInstance().getMinLogLevel() == LogLevel::DEBUG;
+
+        writeConfig("WARN", "format_style=no_brackets\n", true);
+        waitForReloads(before + 3);
+        PlainTextFormatter formatter;
+        const LogRecord record{LogLevel::INFO, "filtered", std::chrono::system_clock::now()};
+        ok = ok && watcher.appliedReloads() == before + 2 && formatter.format(record).empty();
+
+        writer.join();
+        logger.flush();
+    }
+    watcher.stop();
+
+    // A reference taken before the reloads still configures the live settings
+    earlier.setMinLogLevel(LogLevel::ERROR);
+    ok = ok && opLog::Config::getInstance().getMinLogLevel() == LogLevel::ERROR;
+    earlier.setMinLogLevel(LogLevel::TRACE);
+
+    int lines = 0;
+    for (const auto& entry : fs::directory_iterator(dir / "logs")) {
+        std::ifstream in(entry.path());
+        for (std::string line; std::getline(in, line);) ++lines;
+    }
+    ok = ok && written == RECORDS && lines == RECORDS;
+    std::cout << "Config watcher: " << (ok ? "OK" : "FAILED") << std::endl;
+    fs::remove_all(dir);
+    return ok;
+}
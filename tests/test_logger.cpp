@@ -1,12 +1,555 @@
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <csignal>
+#include <condition_variable>
+#include <coroutine>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
 #include "opLog/Logger.h"
 #include "opLog/Config.h"
+#include "opLog/LogDispatcher.h"
+#include "opLog/MemoryBudget.h"
+#include "opLog/TimeSource.h"
+#include "opLog/appender/FileAppender.h"
 
+namespace fs = std::filesystem;
 
-int main() {
+// Runs `crash` in a child whose logger buffers (auto_flush=false), then
+// checks the buffered lines and the crash marker made it to the file.
+bool unitCrashFlush(const char* name, int expectedSignal, const std::string& expectedMarker, void (*crash)()) {
+    const fs::path dir = fs::temp_directory_path() / ("oplog-test-crash-" + std::to_string(::getpid()));
+    fs::remove_all(dir);
+
+    const pid_t child = ::fork();
+    if (child == 0) {
+        auto& config = opLog::Config::getInstance();
+        config.setLogDirectory(dir.string());
+        config.setAutoFlushEnabled(false);
+        config.setColorsEnabled(false);
+        config.setCrashHandlerEnabled(true);
+        config.setCrashBacktraceEnabled(true);
+
+        std::vector<std::unique_ptr<IAppender>> appenders;
+        appenders.push_back(std::make_unique<FileAppender>());
+        Logger logger(nullptr, std::move(appenders));
+        for (int i = 0; i < 100; ++i) logger.info("buffered " + std::to_string(i));
+        ::close(STDERR_FILENO); // Keep the test output clean
+        crash();
+        ::_exit(0);
+    }
+
+    int status = 0;
+    ::waitpid(child, &status, 0);
+    std::string contents;
+    for (const auto& entry : fs::directory_iterator(dir)) {
+        std::ifstream in(entry.path());
+        std::stringstream text;
+        text << in.rdbuf();
+        contents += text.str();
+    }
+
+    const bool ok = WIFSIGNALED(status) && WTERMSIG(status) == expectedSignal &&
+                    contents.find("buffered 99") != std::string::npos &&
+                    contents.find(expectedMarker) != std::string::npos;
+    std::cout << name << ": " << (ok ? "OK" : "FAILED") << std::endl;
+    fs::remove_all(dir);
+    return ok;
+}
+
+// Keeps every record it is handed
+class CaptureAppender final : public IAppender {
+public:
+    std::vector<std::string>& lines;
+    explicit CaptureAppender(std::vector<std::string>& lines) : lines(lines) {}
+    void write(const std::string& message) override { lines.push_back(message); }
+};
+
+bool unitBacktrace() {
+    auto& config = opLog::Config::getInstance();
+    config.setMinLogLevel(LogLevel::INFO);
+    config.setTimestampEnabled(false);
+    config.setColorsEnabled(false);
+    config.setBacktraceSize(3);
+    config.setBacktraceTriggerLevel(LogLevel::ERROR);
+
+    std::vector<std::string> lines;
+    {
+        std::vector<std::unique_ptr<IAppender>> appenders;
+        appenders.push_back(std::make_unique<CaptureAppender>(lines));
+        Logger logger(nullptr, std::move(appenders));
+
+        for (int i = 0; i < 5; ++i) logger.debug("step " + std::to_string(i));
+        logger.info("working");
+        logger.warn("not a trigger");
+        logger.error("failed");
+        logger.error("failed again"); // Ring was emptied by the first trigger
+        logger.trace("after");
+        logger.dumpBacktrace();
+    }
+    config.setBacktraceSize(0);
+    config.setTimestampEnabled(true);
+
+    const std::vector<std::string> expected{
+        "[INFO] working", "[WARN] not a trigger",
+        "[DEBUG] step 2", "[DEBUG] step 3", "[DEBUG] step 4", "[ERROR] failed",
+        "[ERROR] failed again", "[TRACE] after",
+    };
+    const bool ok = lines == expected;
+    std::cout << "Backtrace ring: " << (ok ? "OK" : "FAILED") << std::endl;
+    return ok;
+}
+
+// Appenders added while other threads log: no record is lost or torn
+bool unitAppenderChangesUnderLoad() {
+    auto& config = opLog::Config::getInstance();
+    config.setMinLogLevel(LogLevel::INFO);
+
+    std::vector<std::string> primary;
+    std::vector<std::vector<std::string>> extra(50);
+    {
+        std::vector<std::unique_ptr<IAppender>> appenders;
+        appenders.push_back(std::make_unique<CaptureAppender>(primary));
+        Logger logger(nullptr, std::move(appenders));
+
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 4; ++t) {
+            threads.emplace_back([&logger] {
+                for (int i = 0; i < 10000; ++i) logger.info("record " + std::to_string(i));
+            });
+        }
+        for (auto& lines : extra) {
+            logger.addAppender(std::make_unique<CaptureAppender>(lines));
+            std::this_thread::yield();
+        }
+        for (auto& thread : threads) thread.join();
+
+        const bool counted = logger.getAppenderCount() == 1 + extra.size();
+        if (!counted) primary.clear();
+    }
+
+    const bool ok = primary.size() == 40000 && extra.back().size() <= 40000;
+    std::cout << "Appender changes under load: " << (ok ? "OK" : "FAILED") << std::endl;
+    return ok;
+}
+
+// Many async loggers on a two-thread pool: each keeps its own order, and
+// the pool lets its threads go once idle
+bool unitAsyncLoggers() {
+    auto& config = opLog::Config::getInstance();
+    config.setMinLogLevel(LogLevel::INFO);
+    config.setAsyncLogging(true);
+    config.setAsyncWorkers(2);
+    config.setAsyncQuantum(64);
+    config.setAsyncQueueRecords(1024);
+    config.setAsyncIdleMs(50);
+
+    constexpr int LOGGERS = 8;
+    constexpr int RECORDS = 5000;
+    std::vector<std::vector<std::string>> lines(LOGGERS);
+    std::vector<std::unique_ptr<Logger>> loggers;
+    for (auto& captured : lines) {
+        std::vector<std::unique_ptr<IAppender>> appenders;
+        appenders.push_back(std::make_unique<CaptureAppender>(captured));
+        loggers.push_back(std::make_unique<Logger>(nullptr, std::move(appenders)));
+    }
+    const auto dispatcher = LogDispatcher::shared();
+
+    std::vector<std::thread> threads;
+    for (auto& logger : loggers) {
+        threads.emplace_back([&logger] {
+            for (int i = 0; i < RECORDS; ++i) logger->info(std::to_string(i));
+            logger->flush();
+        });
+    }
+    for (auto& thread : threads) thread.join();
+
+    bool ordered = true;
+    for (const auto& captured : lines) {
+        ordered = ordered && captured.size() == RECORDS;
+        for (int i = 0; ordered && i < RECORDS; ++i) {
+            ordered = captured[i].size() > 7 && captured[i].compare(captured[i].size() - std::to_string(i).size(),
+                                                                    std::string::npos, std::to_string(i)) == 0;
+        }
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    const bool scaledDown = dispatcher->runningWorkers() == 0;
+    loggers.clear();
+    config.setAsyncLogging(false);
+
+    const bool ok = ordered && scaledDown;
+    std::cout << "Async loggers on a shared pool: " << (ok ? "OK" : "FAILED") << std::endl;
+    return ok;
+}
+
+// Appenders that do not write payloads get them on the end of the line; an
+// async logger copies a borrowed payload before the caller reuses it
+bool unitPayloadLogging() {
+    auto& config = opLog::Config::getInstance();
+    config.setMinLogLevel(LogLevel::INFO);
+    config.setTimestampEnabled(false);
+    config.setColorsEnabled(false);
+    config.setPayloadMaxBytes(3);
+
+    std::vector<std::string> sync;
+    std::vector<std::string> async;
+    {
+        std::vector<std::unique_ptr<IAppender>> appenders;
+        appenders.push_back(std::make_unique<CaptureAppender>(sync));
+        Logger logger(nullptr, std::move(appenders));
+        logger.log(LogLevel::INFO, "packet", Payload::borrow("\x00\x01\x7f\x80", 4));
+        logger.info("plain");
+    }
+
+    config.setAsyncLogging(true);
+    {
+        std::vector<std::unique_ptr<IAppender>> appenders;
+        appenders.push_back(std::make_unique<CaptureAppender>(async));
+        Logger logger(nullptr, std::move(appenders));
+        for (int i = 0; i < 100; ++i) {
+            std::string body = "b" + std::to_string(i);
+            logger.log(LogLevel::INFO, "body", Payload::borrow(body.data(), body.size(), Payload::Encoding::RAW));
+            body.assign(body.size(), '?');
+        }
+        logger.flush();
+    }
+    config.setAsyncLogging(false);
+    config.setPayloadMaxBytes(0);
+    config.setTimestampEnabled(true);
+
+    bool ok = sync == std::vector<std::string>{"[INFO] packet 00017f (+1 bytes)", "[INFO] plain"};
+    ok = ok && async.size() == 100;
+    for (int i = 0; ok && i < 100; ++i) {
+        const std::string body = "b" + std::to_string(i);
+        ok = async[i] == "[INFO] body " + body.substr(0, 3) + (body.size() > 3 ? " (+1 bytes)" : "");
+    }
+    std::cout << "Payload logging: " << (ok ? "OK" : "FAILED") << std::endl;
+    return ok;
+}
+
+// Counts flush() calls and, while `held`, keeps the writer waiting
+class GateAppender final : public IAppender {
+public:
+    std::mutex mutex;
+    std::condition_variable opened;
+    bool held{false};
+    int writes{0};
+    int flushes{0};
+    void write(const std::string&) override {
+        std::unique_lock<std::mutex> lock(mutex);
+        opened.wait(lock, [this] { return !held; });
+        ++writes;
+    }
+    void flush() override { ++flushes; }
+    void release() {
+        std::lock_guard<std::mutex> lock(mutex);
+        held = false;
+        opened.notify_all();
+    }
+};
+
+// Usage follows what is charged from many threads, queued async records
+// count until written, and past the budget low levels are shed
+bool unitMemoryBudget() {
+    auto& config = opLog::Config::getInstance();
+    config.setMinLogLevel(LogLevel::TRACE);
+    const size_t baseline = MemoryBudget::usage().current;
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 8; ++t) {
+        threads.emplace_back([t] {
+            std::vector<std::unique_ptr<MemoryBudget::Account>> held;
+            for (int i = 0; i < 20000; ++i) {
+                held.push_back(std::make_unique<MemoryBudget::Account>((i * 7919 + t) % 5000));
+                if (held.size() > 64) held.erase(held.begin());
+            }
+        });
+    }
+    for (auto& thread : threads) thread.join();
+    bool ok = MemoryBudget::usage().current == baseline;
 
+    // Records waiting in an async queue
+    config.setAsyncLogging(true);
+    {
+        auto gate = std::make_unique<GateAppender>();
+        GateAppender& appender = *gate;
+        appender.held = true;
+        std::vector<std::unique_ptr<IAppender>> appenders;
+        appenders.push_back(std::move(gate));
+        Logger logger(nullptr, std::move(appenders));
+
+        for (int i = 0; i < 500; ++i) logger.info(std::string(1000, 'q'));
+        const size_t queued = MemoryBudget::usage().current - baseline;
+        ok = ok && queued >= 499 * 1000;
+        appender.release();
+        logger.flush();
+        ok = ok && MemoryBudget::usage().current - baseline < 64 * 1024;
+    }
+    config.setAsyncLogging(false);
+
+    // Degradation: flush through, then shed below WARN
+    const MemoryBudget::Usage before = MemoryBudget::usage();
+    config.setMemoryBudget(before.current + 1024 * 1024);
+    config.setMemoryFlushPercent(50);
+    config.setMemoryShedLevel(LogLevel::WARN);
+    {
+        auto gate = std::make_unique<GateAppender>();
+        GateAppender& appender = *gate;
+        std::vector<std::unique_ptr<IAppender>> appenders;
+        appenders.push_back(std::move(gate));
+        Logger logger(nullptr, std::move(appenders));
+
+        MemoryBudget::Account hog(0);
+        logger.info("normal");
+        const int flushesNormal = appender.flushes;
+        hog.set(700 * 1024);
+        logger.info("flush early");
+        const int flushesUnderPressure = appender.flushes - flushesNormal;
+        hog.set(2 * 1024 * 1024);
+        logger.debug("shed");
+        logger.info("shed");
+        logger.warn("kept");
+        ok = ok && flushesNormal == 0 && flushesUnderPressure == 1 && appender.writes == 3 &&
+             MemoryBudget::usage().shedRecords == before.shedRecords + 2 &&
+             MemoryBudget::usage().peak >= before.current + 2 * 1024 * 1024;
+        hog.set(0);
+        logger.info("normal again");
+        ok = ok && appender.writes == 4;
+    }
+    config.setMemoryBudget(0);
+    config.setMemoryFlushPercent(75);
+
+    std::cout << "Memory budget: " << (ok ? "OK" : "FAILED") << std::endl;
+    return ok;
+}
+
+// Every clock source stays close to the system clock
+bool unitTimeSources() {
+    bool ok = true;
+    for (const ClockSource source : {ClockSource::PRECISE, ClockSource::COARSE, ClockSource::TSC}) {
+        TimeSource::select(source, 20);
+        for (int i = 0; i < 5 && ok; ++i) {
+            const auto ours = TimeSource::now();
+            const auto reference = std::chrono::system_clock::now();
+            ok = std::chrono::abs(reference - ours) < std::chrono::milliseconds(50);
+            std::this_thread::sleep_for(std::chrono::milliseconds(25)); // Across recalibrations
+        }
+    }
+
+    // TSC readings never step back, across recalibrations and a restart of
+    // the calibrator
+    TimeSource::select(ClockSource::TSC, 5);
+    auto last = TimeSource::now();
+    const auto end = std::chrono::steady_clock::now() + std::chrono::milliseconds(300);
+    bool monotonic = true;
+    while (monotonic && std::chrono::steady_clock::now() < end) {
+        for (int i = 0; i < 1000 && monotonic; ++i) {
+            const auto next = TimeSource::now();
+            monotonic = next >= last;
+            last = next;
+        }
+    }
+    ok = ok && monotonic;
+
+    // A source selected directly survives new loggers and unrelated
+    // settings; changing clock_source switches it
+    const ClockSource tsc = TimeSource::tscAvailable() ? ClockSource::TSC : ClockSource::COARSE;
+    auto& config = opLog::Config::getInstance();
+    TimeSource::select(ClockSource::TSC, 20);
+    {
+        Logger logger(nullptr, {});
+        config.setMinLogLevel(config.getMinLogLevel());
+        ok = ok && TimeSource::current() == tsc;
+    }
+    config.setClockSource(ClockSource::COARSE);
+    ok = ok && TimeSource::current() == ClockSource::COARSE;
+    config.setClockSource(ClockSource::PRECISE);
+    ok = ok && TimeSource::current() == ClockSource::PRECISE;
+    std::cout << "Time sources: " << (ok ? "OK" : "FAILED") << std::endl;
+    return ok;
+}
+
+// Fire-and-forget coroutine
+struct Task {
+    struct promise_type {
+        Task get_return_object() { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+};
+
+// Single-threaded event loop that the executor hook posts to
+class EventLoop {
+    std::mutex mutex_;
+    std::condition_variable ready_;
+    std::deque<std::coroutine_handle<>> handles_;
+
+public:
+    void post(std::coroutine_handle<> handle) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            handles_.push_back(handle);
+        }
+        ready_.notify_one();
+    }
+
+    // Runs posted coroutines until `done` is set
+    void run(const bool& done) {
+        while (!done) {
+            std::unique_lock<std::mutex> lock(mutex_);
+            if (!ready_.wait_for(lock, std::chrono::seconds(10), [this] { return !handles_.empty(); })) return;
+            const auto handle = handles_.front();
+            handles_.pop_front();
+            lock.unlock();
+            handle.resume();
+        }
+    }
+};
+
+Task logThenFlush(const Logger& logger, int records, const std::vector<std::string>& lines, size_t expected,
+                  bool& ok, bool& done) {
+    const auto loopThread = std::this_thread::get_id();
+    for (int i = 0; i < records; ++i) {
+        ok = logger.tryLog(LogLevel::INFO, "queued " + std::to_string(i)) && ok;
+    }
+    co_await logger.flushAsync();
+    ok = ok && lines.size() == expected && std::this_thread::get_id() == loopThread;
+    done = true;
+}
+
+// co_await flushAsync() from a coroutine on an event loop: resumes on the
+// loop, through the executor, after everything logged before it
+bool unitFlushAsync() {
+    auto& config = opLog::Config::getInstance();
+    config.setMinLogLevel(LogLevel::INFO);
+    config.setAsyncQueueRecords(8192); // Room for every tryLog()
+
+    EventLoop loop;
+    bool ok = true;
+    for (const bool async : {true, false}) {
+        config.setAsyncLogging(async);
+        std::vector<std::string> lines;
+        std::vector<std::unique_ptr<IAppender>> appenders;
+        appenders.push_back(std::make_unique<CaptureAppender>(lines));
+        Logger logger(nullptr, std::move(appenders));
+        logger.setExecutor([&loop](std::coroutine_handle<> handle) { loop.post(handle); });
+
+        for (int i = 0; i < 500; ++i) logger.info("logged " + std::to_string(i));
+        bool done = false;
+        bool resumed = true;
+        logThenFlush(logger, 1000, lines, 1500, resumed, done);
+        loop.run(done);
+        ok = ok && done && resumed;
+    }
+    config.setAsyncLogging(false);
+
+    std::cout << "Awaitable flush: " << (ok ? "OK" : "FAILED") << std::endl;
+    return ok;
+}
+
+// Counts lines containing `needle` across the files in `dir` whose name
+// does (or does not) contain `tag`
+size_t countLines(const fs::path& dir, const std::string& tag, bool tagged, const std::string& needle) {
+    size_t count = 0;
+    for (const auto& entry : fs::directory_iterator(dir)) {
+        if ((entry.path().filename().string().find(tag) != std::string::npos) != tagged) continue;
+        std::ifstream in(entry.path());
+        for (std::string line; std::getline(in, line);) {
+            count += line.find(needle) != std::string::npos ? 1 : 0;
+        }
+    }
+    return count;
+}
+
+// fork() while threads log through an async file logger: the child can log
+// right away, to its own per-PID file, and neither process loses or
+// duplicates a record
+bool unitForkWhileLogging() {
+    const fs::path dir = fs::temp_directory_path() / ("oplog-test-fork-" + std::to_string(::getpid()));
+    fs::remove_all(dir);
+
+    auto& config = opLog::Config::getInstance();
+    config.setLogDirectory(dir.string());
+    config.setMinLogLevel(LogLevel::INFO);
+    config.setAutoFlushEnabled(false);
+    config.setColorsEnabled(false);
+    config.setAsyncLogging(true);
+    config.setAsyncWorkers(2);
+    config.setForkPidSuffix(true);
+    TimeSource::select(ClockSource::TSC, 5);
+
+    constexpr int THREADS = 2;
+    constexpr int RECORDS = 20000;
+    constexpr int CHILD_RECORDS = 1000;
+    pid_t child = -1;
+    {
+        std::vector<std::unique_ptr<IAppender>> appenders;
+        appenders.push_back(std::make_unique<FileAppender>());
+        Logger logger(nullptr, std::move(appenders));
+
+        std::vector<std::thread> threads;
+        for (int t = 0; t < THREADS; ++t) {
+            threads.emplace_back([&logger] {
+                for (int i = 0; i < RECORDS; ++i) logger.info("parent " + std::to_string(i));
+            });
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+
+        child = ::fork();
+        if (child == 0) {
+            ::alarm(10); // A lock inherited in the locked state would hang here
+            for (int i = 0; i < CHILD_RECORDS; ++i) logger.info("child " + std::to_string(i));
+            logger.flush();
+            ::_exit(0);
+        }
+        for (auto& thread : threads) thread.join();
+    }
+
+    int status = 0;
+    ::waitpid(child, &status, 0);
+    const std::string childTag = ".p" + std::to_string(child) + ".";
+    const bool ok = WIFEXITED(status) && WEXITSTATUS(status) == 0 &&
+                    countLines(dir, childTag, true, "] child ") == CHILD_RECORDS &&
+                    countLines(dir, childTag, true, "] parent ") == 0 &&
+                    countLines(dir, childTag, false, "] parent ") == THREADS * RECORDS &&
+                    countLines(dir, childTag, false, "] child ") == 0;
+
+    TimeSource::select(ClockSource::PRECISE);
+    config.setForkPidSuffix(false);
+    config.setAsyncLogging(false);
+    config.setAutoFlushEnabled(true);
+    config.setLogDirectory("./logs");
+    fs::remove_all(dir);
+    std::cout << "Fork while logging: " << (ok ? "OK" : "FAILED") << std::endl;
+    return ok;
+}
+
+int main() {
+    bool ok = unitCrashFlush("Crash flush on SIGSEGV", SIGSEGV, "*** opLog: SIGSEGV",
+                             [] { std::raise(SIGSEGV); });
+    ok = unitCrashFlush("Crash flush on std::terminate", SIGABRT,
+                        "*** opLog: std::terminate after uncaught exception: boom",
+                        [] { throw std::runtime_error("boom"); }) && ok;
+    ok = unitBacktrace() && ok;
+    ok = unitAppenderChangesUnderLoad() && ok;
+    ok = unitAsyncLoggers() && ok;
+    ok = unitTimeSources() && ok;
+    ok = unitForkWhileLogging() && ok;
+    ok = unitFlushAsync() && ok;
+    ok = unitPayloadLogging() && ok;
+    ok = unitMemoryBudget() && ok;
 
-        auto& logger = Logger::getInstance();
-        for (int i{0}; i < 5000; ++i)
-            logger.info("Hello World!" + std::to_string(i));
-    return 0;
+    auto& logger = Logger::getInstance();
+    for (int i{0}; i < 5000; ++i)
+        logger.info("Hello World!" + std::to_string(i));
+    return ok ? 0 : 1;
 }
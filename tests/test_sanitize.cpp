@@ -0,0 +1,116 @@
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "opLog/Config.h"
+#include "opLog/Payload.h"
+#include "opLog/appender/FileAppender.h"
+#include "opLog/formatter/MessageSanitizer.h"
+#include "opLog/formatter/PlainTextFormatter.h"
+
+namespace {
+    // Byte-at-a-time versions to check the vector scan against
+    std::size_t referenceFind(const std::string& text) {
+        for (std::size_t i = 0; i < text.size(); ++i) {
+            const auto c = static_cast<unsigned char>(text[i]);
+            if (c < 0x20 || c == 0x7f) return i;
+        }
+        return text.size();
+    }
+
+    std::string referenceEscape(const std::string& text) {
+        static constexpr char HEX[] = "0123456789abcdef";
+        std::string out;
+        for (const char ch : text) {
+            const auto c = static_cast<unsigned char>(ch);
+            if (c == '\n') out += "\\n";
+            else if (c == '\r') out += "\\r";
+            else if (c == '\t') out += "\\t";
+            else if (c < 0x20 || c == 0x7f) out += {'\\', 'x', HEX[c >> 4], HEX[c & 0x0f]};
+            else out += ch;
+        }
+        return out;
+    }
+
+    bool check(const std::string& text) {
+        return MessageSanitizer::findUnsafe(text.data(), text.size()) == referenceFind(text) &&
+               MessageSanitizer::escape(text) == referenceEscape(text);
+    }
+}
+
+int main() {
+    // Every byte value, at every position of the vector blocks and tails
+    bool ok = true;
+    for (int c = 0; c < 256 && ok; ++c) {
+        for (std::size_t size = 1; size <= 80 && ok; ++size) {
+            for (std::size_t at = 0; at < size && ok; ++at) {
+                std::string text(size, 'a');
+                text[at] = static_cast<char>(c);
+                ok = check(text);
+            }
+        }
+    }
+    std::cout << "Single bytes: " << (ok ? "OK" : "FAILED") << std::endl;
+
+    // Random text: mostly printable, with controls, DEL and UTF-8 bytes, read
+    // at every alignment
+    std::mt19937 random(46);
+    std::uniform_int_distribution<int> kind(0, 99);
+    std::uniform_int_distribution<int> byte(0, 255);
+    std::uniform_int_distribution<std::size_t> length(0, 300);
+    bool fuzzOk = true;
+    for (int round = 0; round < 20000 && fuzzOk; ++round) {
+        std::string buffer(length(random) + 32, ' ');
+        const int controls = kind(random) % 4; // Some messages stay clean
+        for (char& ch : buffer) {
+            const int k = kind(random);
+            ch = static_cast<char>(k < controls ? byte(random) % 0x20 : k < 90 ? 0x20 + byte(random) % 0x5f : byte(random));
+        }
+        const std::size_t offset = round % 32;
+        fuzzOk = check(buffer.substr(offset));
+        const std::string escaped = MessageSanitizer::escape(buffer.substr(offset));
+        fuzzOk = fuzzOk && MessageSanitizer::isClean(escaped);
+    }
+    std::cout << "Fuzz: " << (fuzzOk ? "OK" : "FAILED") << std::endl;
+
+    // A forged line and a terminal escape stay inside one record
+    auto& config = opLog::Config::getInstance();
+    config.setColorsEnabled(false);
+    config.setTimestampEnabled(false);
+    PlainTextFormatter formatter;
+    const LogRecord record{LogLevel::INFO, "user=bob\n[ERROR] admin login\x1b[2J", std::chrono::system_clock::now()};
+    const bool plainOk = formatter.format(record) == "[INFO] user=bob\n[ERROR] admin login\x1b[2J";
+    config.setSanitizeMessagesEnabled(true);
+    const bool formatOk = plainOk && formatter.format(record) == "[INFO] user=bob\\n[ERROR] admin login\\x1b[2J";
+    std::cout << "Formatter: " << (formatOk ? "OK" : "FAILED") << std::endl;
+
+    // Raw payloads skip the formatter; FileAppender escapes them itself,
+    // both the small ones it buffers and the large ones it writes gathered
+    const std::filesystem::path dir = std::filesystem::temp_directory_path() / "oplog-test-sanitize";
+    std::filesystem::remove_all(dir);
+    config.setLogDirectory(dir.string());
+    config.setRotationInterval(86400);
+    const std::string small = "id=7\n[ERROR] forged\x1b[2J";
+    std::string large(40000, 'b');
+    for (std::size_t i = 0; i < large.size(); i += 1000) large[i] = '\n';
+    {
+        FileAppender appender;
+        LogRecord payloadRecord{LogLevel::INFO, "", std::chrono::system_clock::now()};
+        payloadRecord.payload = Payload::borrow(small.data(), small.size(), Payload::Encoding::RAW);
+        appender.write(payloadRecord, "small");
+        payloadRecord.payload = Payload::borrow(large.data(), large.size(), Payload::Encoding::RAW);
+        appender.write(payloadRecord, "large");
+    }
+    std::vector<std::string> lines;
+    for (const auto& entry : std::filesystem::directory_iterator(dir)) {
+        std::ifstream in(entry.path());
+        for (std::string line; std::getline(in, line);) lines.push_back(line);
+    }
+    const bool payloadOk = lines == std::vector<std::string>{"small " + referenceEscape(small), "large " + referenceEscape(large)};
+    std::filesystem::remove_all(dir);
+    std::cout << "Raw payloads: " << (payloadOk ? "OK" : "FAILED") << std::endl;
+
+    return ok && fuzzOk && formatOk && payloadOk ? 0 : 1;
+}
@@ -0,0 +1,89 @@
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+#include "opLog/shm/ShmRing.h"
+
+// Four producers race into a small ring while the consumer drains it through
+// a second mapping, as oplog-collector does. Every record must arrive once,
+// intact, and in order per producer.
+bool unitConcurrentProducers(const std::string& name) {
+    std::unique_ptr<ShmRing> producer(ShmRing::create(name, 256));
+    std::unique_ptr<ShmRing> consumer(ShmRing::attach(name));
+    if (!consumer) {
+        std::cout << "Concurrent producers: FAILED (attach)" << std::endl;
+        return false;
+    }
+
+    constexpr int THREADS = 4;
+    constexpr int PER_THREAD = 20000;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < THREADS; ++t) {
+        threads.emplace_back([&, t] {
+            for (int i = 0; i < PER_THREAD; ++i) {
+                // Every 16th record spans several slots
+                std::string message = std::to_string(t) + ":" + std::to_string(i);
+                if (i % 16 == 0) message += std::string(600, 'x');
+                while (!producer->tryWrite(i, LogLevel::INFO, message.data(), message.size())) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+
+    std::vector<int> next(THREADS, 0);
+    bool ok = true;
+    int received = 0;
+    ShmRing::Record record;
+    while (received < THREADS * PER_THREAD && ok) {
+        if (consumer->tryRead(record) != ShmRing::ReadResult::RECORD) {
+            std::this_thread::yield();
+            continue;
+        }
+        const auto colon = record.message.find(':');
+        const int t = std::stoi(record.message.substr(0, colon));
+        const int i = std::stoi(record.message.substr(colon + 1));
+        const size_t expectedLength = colon + 1 + std::to_string(i).size() + (i % 16 == 0 ? 600 : 0);
+        ok = t >= 0 && t < THREADS && i == next[t] && record.timestampNs == i && record.message.size() == expectedLength;
+        ++next[t];
+        ++received;
+    }
+    for (auto& thread : threads) thread.join();
+
+    ok = ok && consumer->tryRead(record) == ShmRing::ReadResult::EMPTY;
+    std::cout << "Concurrent producers: " << (ok ? "OK" : "FAILED") << std::endl;
+    producer->unlink();
+    return ok;
+}
+
+// A full ring drops instead of blocking, and oversized messages are truncated
+bool unitFullRing(const std::string& name) {
+    std::unique_ptr<ShmRing> ring(ShmRing::create(name, 64));
+    const std::string message(100, 'm');
+    int written = 0;
+    while (ring->tryWrite(1, LogLevel::WARN, message.data(), message.size())) ++written;
+    bool ok = written == 64 && ring->dropped() == 1;
+
+    ShmRing::Record record;
+    ok = ok && ring->tryRead(record) == ShmRing::ReadResult::RECORD && record.message == message &&
+         record.level == LogLevel::WARN;
+    while (ring->tryRead(record) == ShmRing::ReadResult::RECORD) {}
+
+    const std::string huge(64 * 1024, 'h');
+    ok = ok && ring->tryWrite(2, LogLevel::ERROR, huge.data(), huge.size()) &&
+         ring->tryRead(record) == ShmRing::ReadResult::RECORD &&
+         record.message.size() < huge.size() && record.message.size() > 3000;
+
+    std::cout << "Full ring: " << (ok ? "OK" : "FAILED") << std::endl;
+    ring->unlink();
+    return ok;
+}
+
+int main() {
+    const std::string prefix = "/oplog-test-" + std::to_string(::getpid());
+    const bool concurrent = unitConcurrentProducers(prefix + "-a");
+    const bool full = unitFullRing(prefix + "-b");
+    return concurrent && full ? 0 : 1;
+}
@@ -0,0 +1,258 @@
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "opLog/Config.h"
+#include "opLog/appender/BinaryFileAppender.h"
+#include "opLog/appender/FileAppender.h"
+#include "opLog/appender/ShardedFileAppender.h"
+#include "opLog/shm/ShmRing.h"
+
+// End-to-end runs of the command line tools on files written by the
+// appenders they belong with. The tool paths come from the build.
+
+namespace fs = std::filesystem;
+
+namespace {
+    // Runs `command` through the shell; returns its stdout and exit status
+    std::string run(const std::string& command, int& status) {
+        std::string output;
+        FILE* pipe = ::popen(command.c_str(), "r");
+        if (!pipe) {
+            status = -1;
+            return output;
+        }
+        char buffer[4096];
+        size_t n;
+        while ((n = std::fread(buffer, 1, sizeof(buffer), pipe)) > 0) {
+            output.append(buffer, n);
+        }
+        const int result = ::pclose(pipe);
+        status = WIFEXITED(result) ? WEXITSTATUS(result) : -1;
+        return output;
+    }
+
+    std::vector<std::string> lines(const std::string& text) {
+        std::vector<std::string> result;
+        std::istringstream in(text);
+        for (std::string line; std::getline(in, line);) {
+            result.push_back(line);
+        }
+        return result;
+    }
+
+    std::string readFile(const fs::path& path) {
+        std::ifstream in(path, std::ios::binary);
+        return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+
+    std::chrono::system_clock::time_point at(int hour, int minute, int second) {
+        std::tm local{};
+        local.tm_year = 2024 - 1900;
+        local.tm_mon = 0;
+        local.tm_mday = 15;
+        local.tm_hour = hour;
+        local.tm_min = minute;
+        local.tm_sec = second;
+        local.tm_isdst = -1;
+        return std::chrono::system_clock::from_time_t(std::mktime(&local));
+    }
+
+    fs::path freshDirectory(const std::string& name) {
+        const fs::path dir = fs::temp_directory_path() / name;
+        fs::remove_all(dir);
+        fs::create_directories(dir);
+        auto& config = opLog::Config::getInstance();
+        config.setLogDirectory(dir.string());
+        config.setRotationInterval(86400);
+        config.setMaxFileSize(100 * 1024 * 1024);
+        return dir;
+    }
+}
+
+// Three threads write interleaved timestamps to their own shards;
+// oplog-merge puts them back in one sequence without the prefixes
+bool unitMerge() {
+    const fs::path dir = freshDirectory("oplog-test-merge");
+    {
+        ShardedFileAppender appender;
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 3; ++t) {
+            threads.emplace_back([&appender, t] {
+                for (int i = 0; i < 200; ++i) {
+                    const int sequence = i * 3 + t;
+                    const LogRecord record{LogLevel::INFO, "", at(10, 0, 0) + std::chrono::milliseconds(sequence)};
+                    appender.write(record, "seq " + std::to_string(sequence));
+                }
+            });
+        }
+        for (auto& thread : threads) thread.join();
+    }
+
+    std::string command = OPLOG_MERGE_PATH;
+    size_t shards = 0;
+    for (const auto& entry : fs::directory_iterator(dir)) {
+        command += " '" + entry.path().string() + "'";
+        ++shards;
+    }
+    int status;
+    const std::vector<std::string> merged = lines(run(command, status));
+
+    bool ok = status == 0 && shards == 3 && merged.size() == 600;
+    for (size_t i = 0; ok && i < merged.size(); ++i) {
+        ok = merged[i] == "seq " + std::to_string(i);
+    }
+    std::cout << "oplog-merge: " << (ok ? "OK" : "FAILED") << std::endl;
+    fs::remove_all(dir);
+    return ok;
+}
+
+// One record a second for a minute, every fifth an ERROR; oplog-query picks
+// a ten second window and a level through the time index
+bool unitQuery() {
+    const fs::path dir = freshDirectory("oplog-test-query");
+    auto& config = opLog::Config::getInstance();
+    config.setTimeIndexEnabled(true);
+    config.setTimeIndexRecords(8);
+    {
+        FileAppender appender;
+        for (int second = 0; second < 60; ++second) {
+            const LogLevel level = second % 5 == 0 ? LogLevel::ERROR : LogLevel::INFO;
+            char line[96];
+            std::snprintf(line, sizeof(line), "[2024-01-15 10:00:%02d] [%s] record %d",
+                          second, level == LogLevel::ERROR ? "ERROR" : "INFO", second);
+            appender.write(LogRecord{level, "", at(10, 0, second)}, line);
+        }
+    }
+    config.setTimeIndexEnabled(false);
+
+    const fs::path file = dir / "2024-01-15-log.txt";
+    int status;
+    const std::vector<std::string> window = lines(run(std::string(OPLOG_QUERY_PATH) +
+        " --from '2024-01-15 10:00:10' --to '2024-01-15 10:00:19' '" + file.string() + "'", status));
+    bool ok = status == 0 && fs::exists(file.string() + ".idx") && window.size() == 10;
+    for (size_t i = 0; ok && i < window.size(); ++i) {
+        ok = window[i].size() > 7 && window[i].substr(window[i].rfind(' ') + 1) == std::to_string(10 + i);
+    }
+
+    const std::vector<std::string> errors = lines(run(std::string(OPLOG_QUERY_PATH) +
+        " --level ERROR '" + file.string() + "'", status));
+    ok = ok && status == 0 && errors.size() == 12 &&
+         std::all_of(errors.begin(), errors.end(), [](const std::string& line) {
+             return line.find("[ERROR]") != std::string::npos;
+         });
+    std::cout << "oplog-query: " << (ok ? "OK" : "FAILED") << std::endl;
+    fs::remove_all(dir);
+    return ok;
+}
+
+// 1000 records in blocks of 100; --stats summarizes them, a plain dump
+// prints them, and a block header with a damaged level byte is reported
+// instead of read out of bounds
+bool unitDump() {
+    const fs::path dir = freshDirectory("oplog-test-dump");
+    auto& config = opLog::Config::getInstance();
+    config.setBinaryBlockRecords(100);
+    {
+        BinaryFileAppender appender;
+        for (int i = 0; i < 1000; ++i) {
+            const LogLevel level = i % 10 == 0 ? LogLevel::WARN : LogLevel::INFO;
+            appender.write(LogRecord{level, "request " + std::to_string(i % 7), at(10, 0, 0) + std::chrono::milliseconds(i)}, "");
+        }
+    }
+    config.setBinaryBlockRecords(4096);
+
+    const fs::path file = *fs::directory_iterator(dir);
+    int status;
+    const std::vector<std::string> stats = lines(run(std::string(OPLOG_DUMP_PATH) + " --stats '" + file.string() + "'", status));
+    bool ok = status == 0 && stats.size() == 11 &&
+              stats.back() == file.string() + ": 10 blocks, 1000 records" &&
+              stats.front().find("100 records") != std::string::npos &&
+              stats.front().find("INFO..WARN") != std::string::npos;
+
+    const std::vector<std::string> records = lines(run(std::string(OPLOG_DUMP_PATH) + " --level WARN '" + file.string() + "'", status));
+    ok = ok && status == 0 && records.size() == 100 && records.front().find("[WARN] request 0") != std::string::npos;
+
+    // minLevel and maxLevel follow the 4-byte magic and 2-byte version; the
+    // header is not covered by the checksum
+    std::string bytes = readFile(file);
+    bytes[6] = static_cast<char>(0xee);
+    bytes[7] = static_cast<char>(0xff);
+    std::ofstream(file, std::ios::binary | std::ios::trunc) << bytes;
+    const std::vector<std::string> damaged = lines(run(std::string(OPLOG_DUMP_PATH) + " --stats '" + file.string() + "'", status));
+    ok = ok && status == 0 && damaged.size() == 11 && damaged.front().find("?..?") != std::string::npos;
+
+    std::cout << "oplog-dump: " << (ok ? "OK" : "FAILED") << std::endl;
+    fs::remove_all(dir);
+    return ok;
+}
+
+// Records published out of order in a ring come out of oplog-collector
+// sorted, in the file its config names
+bool unitCollector() {
+    const fs::path dir = freshDirectory("oplog-test-collector");
+    const fs::path configPath = dir / "collector.conf";
+    std::ofstream(configPath) << "log_directory=" << (dir / "logs").string() << "\n"
+                              << "rotation_interval=86400\nmin_log_level=TRACE\n"
+                              << "enable_colors=false\nenable_timestamp=true\nformat_style=with_brackets\n";
+
+    const std::string prefix = "oplog-test-collect-" + std::to_string(::getpid());
+    std::unique_ptr<ShmRing> ring(ShmRing::create("/" + prefix + "-" + std::to_string(::getpid()), 1024));
+    if (!ring) {
+        std::cout << "oplog-collector: FAILED (ring)" << std::endl;
+        return false;
+    }
+    constexpr int RECORDS = 200;
+    const long long base = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        at(10, 0, 0).time_since_epoch()).count();
+    for (int i = 0; i < RECORDS; ++i) {
+        const int second = (i * 37) % RECORDS; // Every second once, out of order
+        const std::string message = "event " + std::to_string(second);
+        ring->tryWrite(base + second * 1000000000LL, LogLevel::INFO, message.data(), message.size());
+    }
+
+    const pid_t collector = ::fork();
+    if (collector == 0) {
+        ::execl(OPLOG_COLLECTOR_PATH, "oplog-collector", "--config", configPath.c_str(),
+                "--prefix", prefix.c_str(), "--window-ms", "20", static_cast<char*>(nullptr));
+        ::_exit(127);
+    }
+
+    const fs::path output = dir / "logs" / "2024-01-15-log.txt";
+    std::vector<std::string> written;
+    for (int i = 0; i < 500 && written.size() < RECORDS; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        written = lines(readFile(output));
+    }
+    ::kill(collector, SIGTERM);
+    int status = 0;
+    ::waitpid(collector, &status, 0);
+    ring->unlink();
+
+    bool ok = WIFEXITED(status) && WEXITSTATUS(status) == 0 && written.size() == RECORDS;
+    for (size_t i = 0; ok && i < written.size(); ++i) {
+        ok = written[i].size() > 30 && written[i].substr(written[i].find("] [INFO] ") + 9) == "event " + std::to_string(i);
+    }
+    std::cout << "oplog-collector: " << (ok ? "OK" : "FAILED") << std::endl;
+    fs::remove_all(dir);
+    return ok;
+}
+
+int main() {
+    bool ok = unitMerge();
+    ok = unitQuery() && ok;
+    ok = unitDump() && ok;
+    ok = unitCollector() && ok;
+    return ok ? 0 : 1;
+}
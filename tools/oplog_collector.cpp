@@ -0,0 +1,272 @@
+// oplog-collector: drain the shared-memory rings of every process logging
+// with shm_ring=true and write their records, ordered by timestamp, to the
+// configured log files.
+//
+// Usage: oplog-collector [--config path] [--prefix PREFIX] [--window-ms MS]
+//
+// Rings are found by scanning /dev/shm for <prefix>-<pid> (the prefix
+// defaults to shm_ring_prefix). Records are held for --window-ms (default
+// 100) before being written, so records from different processes that
+// arrive slightly out of order still come out sorted. The collector is the
+// only writer of the log files and owns their rotation (FileAppender or
+// BinaryFileAppender, per file_format).
+//
+// When a ring's owner has exited the ring is drained and unlinked. If the
+// owner died in the middle of a write the unpublished record can never
+// complete; the ring is retired once it has been stuck for a second.
+// SIGINT/SIGTERM drain every ring and flush before exiting.
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <memory>
+#include <queue>
+#include <string>
+#include <thread>
+#include <vector>
+#include <dirent.h>
+#include <sys/stat.h>
+#include "opLog/Config.h"
+#include "opLog/appender/BinaryFileAppender.h"
+#include "opLog/appender/FileAppender.h"
+#include "opLog/formatter/PlainTextFormatter.h"
+#include "opLog/shm/ShmRing.h"
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    constexpr const char* SHM_DIR = "/dev/shm";
+    constexpr auto RESCAN_INTERVAL = std::chrono::milliseconds(500);
+    constexpr auto STUCK_TIMEOUT = std::chrono::seconds(1);
+    constexpr size_t READS_PER_PASS = 4096; // Per ring, so one busy ring cannot starve the rest
+
+    volatile std::sig_atomic_t stopRequested = 0;
+
+    void onSignal(int) { stopRequested = 1; }
+
+    struct Source {
+        std::unique_ptr<ShmRing> ring;
+        ino_t inode{0};
+        std::uint64_t reportedDrops{0};
+        Clock::time_point pendingSince{};
+        bool pending{false};
+    };
+
+    struct Pending {
+        ShmRing::Record record;
+        std::uint64_t arrival; // Keeps equal timestamps in arrival order
+
+        bool operator>(const Pending& other) const {
+            if (record.timestampNs != other.record.timestampNs) return record.timestampNs > other.record.timestampNs;
+            return arrival > other.arrival;
+        }
+    };
+
+    bool ownerAlive(pid_t pid) {
+        return ::kill(pid, 0) == 0 || errno != ESRCH;
+    }
+
+    long long nowNs() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+    }
+
+    class Collector {
+    private:
+        std::string prefix_;
+        std::chrono::milliseconds window_;
+        std::map<std::string, Source> sources_;
+        std::priority_queue<Pending, std::vector<Pending>, std::greater<>> heap_;
+        std::uint64_t arrivals_{0};
+        PlainTextFormatter formatter_;
+        std::unique_ptr<IAppender> appender_;
+
+        void retire(std::map<std::string, Source>::iterator it) {
+            std::cerr << "oplog-collector: retiring " << it->first << " (owner "
+                      << it->second.ring->ownerPid() << " exited)" << std::endl;
+            it->second.ring->unlink();
+            sources_.erase(it);
+        }
+
+    public:
+        Collector(std::string prefix, std::chrono::milliseconds window)
+            : prefix_(std::move(prefix) + "-"), window_(window) {
+            if (opLog::Config::getInstance().isBinaryFormat()) {
+                appender_ = std::make_unique<BinaryFileAppender>();
+            } else {
+                appender_ = std::make_unique<FileAppender>();
+            }
+        }
+
+        // Picks up new rings and rings recreated under the same name
+        void scan() {
+            DIR* dir = ::opendir(SHM_DIR);
+            if (!dir) return;
+            while (const dirent* entry = ::readdir(dir)) {
+                const std::string name = entry->d_name;
+                if (name.compare(0, prefix_.size(), prefix_) != 0) continue;
+
+                struct stat st{};
+                if (::stat((std::string(SHM_DIR) + "/" + name).c_str(), &st) != 0) continue;
+
+                const std::string shmName = "/" + name;
+                auto it = sources_.find(shmName);
+                if (it != sources_.end() && it->second.inode == st.st_ino) continue;
+
+                ShmRing* ring = ShmRing::attach(shmName);
+                if (!ring) continue; // Still being created
+                Source& source = sources_[shmName];
+                source = Source{};
+                source.ring.reset(ring);
+                source.inode = st.st_ino;
+            }
+            ::closedir(dir);
+        }
+
+        // Moves published records into the heap; returns how many were read
+        size_t drain() {
+            size_t total = 0;
+            const auto now = Clock::now();
+            for (auto it = sources_.begin(); it != sources_.end();) {
+                Source& source = it->second;
+                ShmRing::ReadResult result = ShmRing::ReadResult::EMPTY;
+                size_t reads = 0;
+                for (; reads < READS_PER_PASS; ++reads) {
+                    Pending pending{{}, arrivals_};
+                    result = source.ring->tryRead(pending.record);
+                    if (result != ShmRing::ReadResult::RECORD) break;
+                    ++arrivals_;
+                    heap_.push(std::move(pending));
+                }
+                total += reads;
+
+                const std::uint64_t dropped = source.ring->dropped();
+                if (dropped != source.reportedDrops) {
+                    std::cerr << "oplog-collector: " << it->first << " dropped "
+                              << dropped - source.reportedDrops << " records (ring full)" << std::endl;
+                    source.reportedDrops = dropped;
+                }
+
+                if (result == ShmRing::ReadResult::PENDING) {
+                    if (!source.pending) {
+                        source.pending = true;
+                        source.pendingSince = now;
+                    }
+                } else {
+                    source.pending = false;
+                }
+
+                const bool finished = result == ShmRing::ReadResult::EMPTY ||
+                                      (source.pending && now - source.pendingSince > STUCK_TIMEOUT);
+                if (finished && !ownerAlive(source.ring->ownerPid())) {
+                    auto retired = it++;
+                    retire(retired);
+                    continue;
+                }
+                ++it;
+            }
+            return total;
+        }
+
+        // Writes every held record older than `cutoffNs`
+        void emit(long long cutoffNs) {
+            while (!heap_.empty() && heap_.top().record.timestampNs <= cutoffNs) {
+                const ShmRing::Record& record = heap_.top().record;
+                const LogRecord logRecord{
+                    record.level, record.message,
+                    std::chrono::system_clock::time_point(
+                        std::chrono::duration_cast<std::chrono::system_clock::duration>(
+                            std::chrono::nanoseconds(record.timestampNs)))
+                };
+                const std::string formatted = formatter_.format(logRecord);
+                if (!formatted.empty()) {
+                    appender_->write(logRecord, formatted);
+                }
+                heap_.pop();
+            }
+        }
+
+        void run() {
+            auto lastScan = Clock::time_point{};
+            auto idleSleep = std::chrono::milliseconds(1);
+            bool dirty = false;
+
+            while (!stopRequested) {
+                if (Clock::now() - lastScan >= RESCAN_INTERVAL) {
+                    scan();
+                    lastScan = Clock::now();
+                }
+
+                const size_t read = drain();
+                const bool hadWork = read > 0 || !heap_.empty();
+                emit(nowNs() - std::chrono::duration_cast<std::chrono::nanoseconds>(window_).count());
+
+                if (read > 0) {
+                    dirty = true;
+                    idleSleep = std::chrono::milliseconds(1);
+                    continue;
+                }
+                if (dirty && heap_.empty()) {
+                    appender_->flush(); // Idle: make what we have visible
+                    dirty = false;
+                }
+                std::this_thread::sleep_for(hadWork ? std::chrono::milliseconds(1) : idleSleep);
+                idleSleep = std::min(idleSleep * 2, std::chrono::milliseconds(50));
+            }
+
+            // Shutdown: take everything that is published, then write it all
+            scan();
+            while (drain() > 0) {}
+            emit(std::numeric_limits<long long>::max());
+            appender_->flush();
+        }
+    };
+
+    void usage() {
+        std::cerr << "Usage: oplog-collector [--config path] [--prefix PREFIX] [--window-ms MS]" << std::endl;
+    }
+}
+
+int main(int argc, char** argv) {
+    std::string configPath;
+    std::string prefix;
+    long windowMs = 100;
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--config" && i + 1 < argc) {
+            configPath = argv[++i];
+        } else if (arg == "--prefix" && i + 1 < argc) {
+            prefix = argv[++i];
+        } else if (arg == "--window-ms" && i + 1 < argc) {
+            windowMs = std::strtol(argv[++i], nullptr, 10);
+            if (windowMs < 0) {
+                usage();
+                return 2;
+            }
+        } else if (arg == "-h" || arg == "--help") {
+            usage();
+            return 0;
+        } else {
+            usage();
+            return 2;
+        }
+    }
+
+    opLog::Config::initialize(configPath);
+    if (prefix.empty()) {
+        prefix = opLog::Config::getInstance().getShmRingPrefix();
+    }
+
+    std::signal(SIGINT, onSignal);
+    std::signal(SIGTERM, onSignal);
+
+    Collector collector(prefix, std::chrono::milliseconds(windowMs));
+    collector.run();
+    return 0;
+}
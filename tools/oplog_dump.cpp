@@ -0,0 +1,138 @@
+// oplog-dump: print or summarize binary log files written by BinaryFileAppender.
+//
+// Usage: oplog-dump [--from TIME] [--to TIME] [--level LEVEL]
+//                   [--format DATETIME_FORMAT] [--stats] file...
+//
+// Blocks whose time or level summary cannot match are skipped without being
+// decoded. --stats prints the block summaries instead of the records.
+
+#include <cerrno>
+#include <climits>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "opLog/binary/BinaryLogReader.h"
+
+namespace {
+    const char* const LEVEL_NAMES[] = {"TRACE", "DEBUG", "INFO", "WARN", "ERROR", "FATAL"};
+
+    // Block headers are not covered by the checksum, so their level bytes
+    // may hold anything
+    const char* levelName(LogLevel level) {
+        const auto index = static_cast<unsigned>(level);
+        return index < sizeof(LEVEL_NAMES) / sizeof(LEVEL_NAMES[0]) ? LEVEL_NAMES[index] : "?";
+    }
+
+    bool parseLevel(const std::string& text, LogLevel& level) {
+        for (int i = 0; i < 6; ++i) {
+            if (text == LEVEL_NAMES[i]) {
+                level = static_cast<LogLevel>(i);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool parseTime(const std::string& text, const std::string& format, long long& timestampNs) {
+        std::tm local{};
+        if (strptime(text.c_str(), format.c_str(), &local) == nullptr) {
+            return false;
+        }
+        local.tm_isdst = -1;
+        timestampNs = static_cast<long long>(std::mktime(&local)) * 1000000000LL;
+        return true;
+    }
+
+    std::string formatTime(long long timestampNs, const std::string& format) {
+        const auto seconds = static_cast<std::time_t>(timestampNs / 1000000000LL);
+        std::tm local{};
+        localtime_r(&seconds, &local);
+        char text[80];
+        const size_t n = std::strftime(text, sizeof(text), format.c_str(), &local);
+        std::snprintf(text + n, sizeof(text) - n, ".%03lld", (timestampNs / 1000000LL) % 1000);
+        return text;
+    }
+
+    void usage() {
+        std::cerr << "Usage: oplog-dump [--from TIME] [--to TIME] [--level LEVEL] "
+                     "[--format DATETIME_FORMAT] [--stats] file..." << std::endl;
+    }
+}
+
+int main(int argc, char** argv) {
+    BinaryLogReader::Filter filter;
+    std::string format = "%Y-%m-%d %H:%M:%S";
+    std::string from, to;
+    bool stats = false;
+    std::vector<std::string> files;
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--from" && i + 1 < argc) {
+            from = argv[++i];
+        } else if (arg == "--to" && i + 1 < argc) {
+            to = argv[++i];
+        } else if (arg == "--format" && i + 1 < argc) {
+            format = argv[++i];
+        } else if (arg == "--level" && i + 1 < argc) {
+            if (!parseLevel(argv[++i], filter.minLevel)) {
+                std::cerr << "oplog-dump: unknown level " << argv[i] << std::endl;
+                return 2;
+            }
+        } else if (arg == "--stats") {
+            stats = true;
+        } else if (arg == "-h" || arg == "--help") {
+            usage();
+            return 0;
+        } else {
+            files.push_back(arg);
+        }
+    }
+    if (files.empty()) {
+        usage();
+        return 2;
+    }
+    if ((!from.empty() && !parseTime(from, format, filter.fromNs)) ||
+        (!to.empty() && !parseTime(to, format, filter.toNs))) {
+        std::cerr << "oplog-dump: cannot parse time, expected format " << format << std::endl;
+        return 2;
+    }
+    if (!to.empty()) {
+        filter.toNs += 999999999LL; // --to is inclusive at second resolution
+    }
+
+    int status = 0;
+    for (const auto& file : files) {
+        try {
+            BinaryLogReader reader(file);
+            if (stats) {
+                size_t records = 0;
+                for (const auto& block : reader.blocks()) {
+                    records += block.recordCount;
+                    std::cout << file << " @" << block.offset << ": " << block.recordCount << " records, "
+                              << formatTime(block.minTimestampNs, format) << " .. "
+                              << formatTime(block.maxTimestampNs, format) << ", "
+                              << levelName(block.minLevel) << ".." << levelName(block.maxLevel) << "\n";
+                }
+                std::cout << file << ": " << reader.blocks().size() << " blocks, " << records << " records"
+                          << (reader.isTruncated() ? " (truncated tail)" : "") << "\n";
+                continue;
+            }
+
+            std::string line;
+            reader.read(filter, [&](long long timestampNs, LogLevel level, std::string_view message) {
+                line.assign("[").append(formatTime(timestampNs, format)).append("] [")
+                    .append(levelName(level)).append("] ").append(message).push_back('\n');
+                std::fwrite(line.data(), 1, line.size(), stdout);
+            });
+        } catch (const std::exception& e) {
+            std::cerr << "oplog-dump: " << e.what() << std::endl;
+            status = 1;
+        }
+    }
+    std::fflush(stdout);
+    return status;
+}
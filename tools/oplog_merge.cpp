@@ -0,0 +1,211 @@
+// oplog-merge: merge per-thread shard files written by ShardedFileAppender
+// into one stream ordered by record timestamp.
+//
+// Usage: oplog-merge [-o output] [--keep-timestamps] shard...
+//
+// Inputs are mmap'd and merged with a k-way heap, so memory stays bounded by
+// the number of shards (one cursor each) plus a fixed output buffer, no
+// matter how large the shards are. Records with equal timestamps keep the
+// order of the shards on the command line.
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <queue>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "opLog/appender/ShardedFileAppender.h"
+
+namespace {
+    constexpr size_t OUTPUT_BUFFER = 1 << 20;
+    constexpr size_t RELEASE_CHUNK = 64 << 20; // Drop consumed pages in 64 MB steps
+
+    struct Cursor {
+        const char* base{nullptr};
+        size_t size{0};
+        size_t pos{0};      // Start of the current line
+        size_t lineEnd{0};  // One past its newline (or end of file)
+        size_t released{0}; // Bytes already given back with MADV_DONTNEED
+        long long timestamp{0};
+    };
+
+    bool parseTimestamp(const char* line, size_t length, long long& out) {
+        const size_t digits = ShardedFileAppender::kTimestampPrefix - 1;
+        if (length < ShardedFileAppender::kTimestampPrefix || line[digits] != ' ') {
+            return false;
+        }
+        long long value = 0;
+        for (size_t i = 0; i < digits; ++i) {
+            if (line[i] < '0' || line[i] > '9') return false;
+            value = value * 10 + (line[i] - '0');
+        }
+        out = value;
+        return true;
+    }
+
+    // Moves the cursor to its next line; false once the shard is exhausted.
+    // Lines without a timestamp prefix inherit the previous one.
+    bool advance(Cursor& cursor) {
+        cursor.pos = cursor.lineEnd;
+        if (cursor.pos >= cursor.size) {
+            return false;
+        }
+        const void* newline = std::memchr(cursor.base + cursor.pos, '\n', cursor.size - cursor.pos);
+        cursor.lineEnd = newline ? static_cast<const char*>(newline) - cursor.base + 1 : cursor.size;
+        parseTimestamp(cursor.base + cursor.pos, cursor.lineEnd - cursor.pos, cursor.timestamp);
+
+        if (cursor.pos - cursor.released >= RELEASE_CHUNK) {
+            const size_t page = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+            const size_t upTo = cursor.pos / page * page;
+            ::madvise(const_cast<char*>(cursor.base) + cursor.released, upTo - cursor.released, MADV_DONTNEED);
+            cursor.released = upTo;
+        }
+        return true;
+    }
+
+    bool openShard(const std::string& path, Cursor& cursor) {
+        const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            std::cerr << "oplog-merge: cannot open " << path << ": " << std::strerror(errno) << std::endl;
+            return false;
+        }
+        struct stat st{};
+        if (::fstat(fd, &st) != 0 || st.st_size == 0) {
+            ::close(fd);
+            return st.st_size == 0;
+        }
+
+        void* mapping = ::mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd); // The mapping keeps the file alive; hundreds of shards need no fds
+        if (mapping == MAP_FAILED) {
+            std::cerr << "oplog-merge: cannot map " << path << ": " << std::strerror(errno) << std::endl;
+            return false;
+        }
+        ::madvise(mapping, static_cast<size_t>(st.st_size), MADV_SEQUENTIAL);
+
+        cursor.base = static_cast<const char*>(mapping);
+        cursor.size = static_cast<size_t>(st.st_size);
+        return true;
+    }
+
+    class Output {
+        int fd_;
+        std::string buffer_;
+    public:
+        explicit Output(int fd) : fd_(fd) { buffer_.reserve(OUTPUT_BUFFER); }
+        ~Output() { flush(); }
+
+        void append(const char* data, size_t size) {
+            if (buffer_.size() + size > OUTPUT_BUFFER) flush();
+            buffer_.append(data, size);
+        }
+
+        void flush() {
+            const char* data = buffer_.data();
+            size_t remaining = buffer_.size();
+            while (remaining > 0) {
+                const ssize_t n = ::write(fd_, data, remaining);
+                if (n < 0) {
+                    if (errno == EINTR) continue;
+                    std::cerr << "oplog-merge: write failed: " << std::strerror(errno) << std::endl;
+                    std::exit(1);
+                }
+                data += n;
+                remaining -= static_cast<size_t>(n);
+            }
+            buffer_.clear();
+        }
+    };
+
+    void usage() {
+        std::cerr << "Usage: oplog-merge [-o output] [--keep-timestamps] shard..." << std::endl;
+    }
+}
+
+int main(int argc, char** argv) {
+    std::string outputPath;
+    bool keepTimestamps = false;
+    std::vector<std::string> inputs;
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "-o" && i + 1 < argc) {
+            outputPath = argv[++i];
+        } else if (arg == "--keep-timestamps") {
+            keepTimestamps = true;
+        } else if (arg == "-h" || arg == "--help") {
+            usage();
+            return 0;
+        } else {
+            inputs.push_back(arg);
+        }
+    }
+    if (inputs.empty()) {
+        usage();
+        return 2;
+    }
+
+    std::vector<Cursor> cursors(inputs.size());
+    for (size_t i = 0; i < inputs.size(); ++i) {
+        if (!openShard(inputs[i], cursors[i])) {
+            return 1;
+        }
+    }
+
+    int outFd = STDOUT_FILENO;
+    if (!outputPath.empty()) {
+        outFd = ::open(outputPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (outFd < 0) {
+            std::cerr << "oplog-merge: cannot create " << outputPath << ": " << std::strerror(errno) << std::endl;
+            return 1;
+        }
+    }
+
+    // Min-heap on (timestamp, shard index)
+    using Entry = std::pair<long long, size_t>;
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<>> heap;
+    for (size_t i = 0; i < cursors.size(); ++i) {
+        if (advance(cursors[i])) {
+            heap.push({cursors[i].timestamp, i});
+        }
+    }
+
+    {
+        Output output(outFd);
+        while (!heap.empty()) {
+            const size_t index = heap.top().second;
+            heap.pop();
+
+            Cursor& cursor = cursors[index];
+            const char* line = cursor.base + cursor.pos;
+            size_t length = cursor.lineEnd - cursor.pos;
+            long long ignored;
+            if (!keepTimestamps && parseTimestamp(line, length, ignored)) {
+                line += ShardedFileAppender::kTimestampPrefix;
+                length -= ShardedFileAppender::kTimestampPrefix;
+            }
+            output.append(line, length);
+            if (length == 0 || line[length - 1] != '\n') {
+                output.append("\n", 1);
+            }
+
+            if (advance(cursor)) {
+                heap.push({cursor.timestamp, index});
+            }
+        }
+    }
+
+    for (auto& cursor : cursors) {
+        if (cursor.base) ::munmap(const_cast<char*>(cursor.base), cursor.size);
+    }
+    if (outFd != STDOUT_FILENO) {
+        ::close(outFd);
+    }
+    return 0;
+}
@@ -0,0 +1,199 @@
+// oplog-query: print the records of text log files that fall in a time range.
+//
+// Usage: oplog-query [--from TIME] [--to TIME] [--level LEVEL]
+//                    [--format DATETIME_FORMAT] file...
+//
+// TIME uses DATETIME_FORMAT (default "%Y-%m-%d %H:%M:%S", as in opLog.conf).
+// Each file is mmap'd and its .idx sidecar (see TimeIndex) is used to jump
+// close to --from instead of scanning from the start. A missing or stale
+// index is rebuilt from the log text and saved back when possible.
+// Lines without a timestamp or level are treated as continuations of the
+// record before them.
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "opLog/appender/TimeIndex.h"
+
+namespace {
+    constexpr size_t OUTPUT_BUFFER = 1 << 20;
+    constexpr size_t DEFAULT_INDEX_RECORDS = 1000;
+    constexpr size_t DEFAULT_INDEX_BYTES = 64 * 1024;
+
+    struct Query {
+        long long from{LLONG_MIN};
+        long long to{LLONG_MAX};
+        int minLevel{0};
+        std::string dateTimeFormat{"%Y-%m-%d %H:%M:%S"};
+    };
+
+    std::string output;
+
+    void flushOutput() {
+        const char* data = output.data();
+        size_t remaining = output.size();
+        while (remaining > 0) {
+            const ssize_t n = ::write(STDOUT_FILENO, data, remaining);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                std::exit(1); // Reader went away (e.g. | head)
+            }
+            data += n;
+            remaining -= static_cast<size_t>(n);
+        }
+        output.clear();
+    }
+
+    bool endsWith(const std::string& text, const std::string& suffix) {
+        return text.size() >= suffix.size() && text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+    }
+
+    // Offset to start scanning at: the last indexed record before `from`
+    std::uint64_t seekOffset(const std::vector<TimeIndex::Entry>& entries, long long from) {
+        auto it = std::lower_bound(entries.begin(), entries.end(), from,
+                                   [](const TimeIndex::Entry& entry, long long t) { return entry.timestampNs < t; });
+        return it == entries.begin() ? 0 : std::prev(it)->offset;
+    }
+
+    bool queryFile(const std::string& path, const Query& query) {
+        if (endsWith(path, TimeIndex::kSuffix)) {
+            return true; // Globs like logs/* pick up the sidecars too
+        }
+        if (endsWith(path, ".gz") || endsWith(path, ".zst")) {
+            std::cerr << "oplog-query: skipping compressed file " << path << std::endl;
+            return true;
+        }
+
+        const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            std::cerr << "oplog-query: cannot open " << path << ": " << std::strerror(errno) << std::endl;
+            return false;
+        }
+        struct stat st{};
+        if (::fstat(fd, &st) != 0 || st.st_size == 0) {
+            ::close(fd);
+            return true;
+        }
+        const size_t size = static_cast<size_t>(st.st_size);
+        void* mapping = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (mapping == MAP_FAILED) {
+            std::cerr << "oplog-query: cannot map " << path << ": " << std::strerror(errno) << std::endl;
+            return false;
+        }
+        const char* data = static_cast<const char*>(mapping);
+
+        // Bring the index up to date with the log before trusting it
+        const std::string indexPath = path + TimeIndex::kSuffix;
+        std::vector<TimeIndex::Entry> entries = TimeIndex::load(indexPath, size);
+        const size_t loaded = entries.size();
+        TimeIndex::build(data, size, entries.empty() ? 0 : entries.back().offset, query.dateTimeFormat,
+                         DEFAULT_INDEX_RECORDS, DEFAULT_INDEX_BYTES, entries);
+        if (entries.size() != loaded || ::access(indexPath.c_str(), F_OK) != 0) {
+            TimeIndex::save(indexPath, entries); // Read-only directories just skip this
+        }
+
+        std::uint64_t offset = seekOffset(entries, query.from);
+        ::madvise(const_cast<char*>(data) + offset / 4096 * 4096, size - offset / 4096 * 4096, MADV_SEQUENTIAL);
+
+        long long lastTimestamp = LLONG_MIN;
+        bool lastMatched = false;
+        while (offset < size) {
+            const void* newline = std::memchr(data + offset, '\n', size - offset);
+            const size_t end = newline ? static_cast<const char*>(newline) - data + 1 : size;
+            const char* line = data + offset;
+            const size_t length = end - offset;
+
+            long long timestamp;
+            const bool hasTimestamp = TimeIndex::parseTimestamp(line, length, query.dateTimeFormat, timestamp);
+            const int level = TimeIndex::parseLevel(line, length);
+            if (hasTimestamp) {
+                if (timestamp > query.to) {
+                    break;
+                }
+                lastTimestamp = timestamp;
+            }
+
+            bool matched;
+            if (!hasTimestamp && level < 0) {
+                matched = lastMatched; // Continuation line
+            } else {
+                matched = lastTimestamp >= query.from && lastTimestamp <= query.to && level >= query.minLevel;
+            }
+            if (matched) {
+                if (output.size() + length + 1 > OUTPUT_BUFFER) flushOutput();
+                output.append(line, length);
+                if (line[length - 1] != '\n') output.push_back('\n');
+            }
+            lastMatched = matched;
+            offset = end;
+        }
+
+        ::munmap(mapping, size);
+        return true;
+    }
+
+    void usage() {
+        std::cerr << "Usage: oplog-query [--from TIME] [--to TIME] [--level LEVEL] "
+                     "[--format DATETIME_FORMAT] file..." << std::endl;
+    }
+}
+
+int main(int argc, char** argv) {
+    Query query;
+    std::string from, to;
+    std::vector<std::string> files;
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--from" && i + 1 < argc) {
+            from = argv[++i];
+        } else if (arg == "--to" && i + 1 < argc) {
+            to = argv[++i];
+        } else if (arg == "--format" && i + 1 < argc) {
+            query.dateTimeFormat = argv[++i];
+        } else if (arg == "--level" && i + 1 < argc) {
+            const std::string level = argv[++i];
+            query.minLevel = TimeIndex::parseLevel(level.c_str(), level.size());
+            if (query.minLevel < 0) {
+                std::cerr << "oplog-query: unknown level " << level << std::endl;
+                return 2;
+            }
+        } else if (arg == "-h" || arg == "--help") {
+            usage();
+            return 0;
+        } else {
+            files.push_back(arg);
+        }
+    }
+    if (files.empty()) {
+        usage();
+        return 2;
+    }
+
+    if (!from.empty() && !TimeIndex::parseTimestamp(from.c_str(), from.size(), query.dateTimeFormat, query.from)) {
+        std::cerr << "oplog-query: cannot parse --from " << from << std::endl;
+        return 2;
+    }
+    if (!to.empty() && !TimeIndex::parseTimestamp(to.c_str(), to.size(), query.dateTimeFormat, query.to)) {
+        std::cerr << "oplog-query: cannot parse --to " << to << std::endl;
+        return 2;
+    }
+
+    output.reserve(OUTPUT_BUFFER);
+    bool ok = true;
+    for (const auto& file : files) {
+        ok = queryFile(file, query) && ok;
+    }
+    flushOutput();
+    return ok ? 0 : 1;
+}